@@ -1,315 +1,2214 @@
+#define _GNU_SOURCE
+
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
 #include "basicvector.h"
 
-struct basicvector_s {
-    struct basicvector_entry_s *starting_entry;
-    int cached_length;
-};
+/*
+ * USDT probes (provider "basicvector") are compiled in whenever <sys/sdt.h> is available, unless
+ * BASICVECTOR_NO_PROBES is defined. Each probe is a single nop until a tracer attaches to it.
+ */
+#if !defined(BASICVECTOR_NO_PROBES) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define BASICVECTOR_PROBES
+#endif
+#endif
+
+#ifdef BASICVECTOR_PROBES
+#define BASICVECTOR_PROBE_ENTRY(name, vector, index) \
+    DTRACE_PROBE3(basicvector, name##_entry, vector, index, basicvector_internal_probe_length(vector))
+#define BASICVECTOR_PROBE_RETURN(name, vector, index, length, walked, status) \
+    DTRACE_PROBE5(basicvector, name##_return, vector, index, length, walked, status)
+#else
+#define BASICVECTOR_PROBE_ENTRY(name, vector, index) ((void) 0)
+#define BASICVECTOR_PROBE_RETURN(name, vector, index, length, walked, status) ((void) (length), (void) (walked))
+#endif
+
+#ifdef BASICVECTOR_STATS
+#define BASICVECTOR_STAT_ADD(vector, counter, amount) ((vector)->stats.counter += (amount))
+#define BASICVECTOR_STAT_PEAK(vector) do { \
+        if ((vector)->length > (vector)->stats.peak_length) (vector)->stats.peak_length = (vector)->length; \
+    } while (0)
+#else
+#define BASICVECTOR_STAT_ADD(vector, counter, amount) ((void) 0)
+#define BASICVECTOR_STAT_PEAK(vector) ((void) 0)
+#endif
+
+/*
+ * With BASICVECTOR_ACCOUNTING, storage and vector structures of all vectors are summed up in process-wide counters
+ */
+#ifdef BASICVECTOR_ACCOUNTING
+static atomic_size_t basicvector_internal_accounted_storage_bytes = 0;
+static atomic_size_t basicvector_internal_accounted_vector_count = 0;
+
+#define BASICVECTOR_ACCOUNT_ADD(counter, amount) \
+    atomic_fetch_add_explicit(&basicvector_internal_accounted_##counter, (amount), memory_order_relaxed)
+#define BASICVECTOR_ACCOUNT_SUB(counter, amount) \
+    atomic_fetch_sub_explicit(&basicvector_internal_accounted_##counter, (amount), memory_order_relaxed)
+#else
+#define BASICVECTOR_ACCOUNT_ADD(counter, amount) ((void) 0)
+#define BASICVECTOR_ACCOUNT_SUB(counter, amount) ((void) 0)
+#endif
+
+#ifdef BASICVECTOR_AUTO_COMPACT
+// Storage is shrunk once less than 1/BASICVECTOR_AUTO_COMPACT_RATIO of it is used, keeping room to grow twice over
+#define BASICVECTOR_AUTO_COMPACT_RATIO 4
+#define BASICVECTOR_AUTO_COMPACT_CHECK(vector) do { \
+        if ((vector)->capacity > BASICVECTOR_SMALL_CAPACITY && (vector)->length < (vector)->capacity / BASICVECTOR_AUTO_COMPACT_RATIO) { \
+            basicvector_internal_shrink((vector), (vector)->length * 2); \
+        } \
+    } while (0)
+#else
+#define BASICVECTOR_AUTO_COMPACT_CHECK(vector) ((void) 0)
+#endif
+
+#define BASICVECTOR_MIN_CAPACITY 4
+
+// Storage of this size and above is allocated in whole huge pages, so that the kernel can back it with them
+#define BASICVECTOR_HUGE_PAGE_SIZE ((size_t) 2 * 1024 * 1024)
+
+#define BASICVECTOR_MAX_LENGTH (SIZE_MAX / sizeof(void *))
+
+/*
+ * Passes count items starting at items to dealloc_batch, in slices small enough for its int count
+ */
+static void basicvector_internal_dealloc_batches(
+    void **items,
+    size_t count,
+    void (*dealloc_batch)(void **items, int count, void *user_data),
+    void *user_data
+) {
+    while (count > 0) {
+        int batch = count > INT_MAX ? INT_MAX : (int) count;
+
+        dealloc_batch(items, batch, user_data);
+
+        items += batch;
+        count -= (size_t) batch;
+    }
+}
+
+static inline long long basicvector_internal_probe_length(struct basicvector_s *vector) {
+    return vector == NULL ? -1 : (long long) vector->length;
+}
+
+/*
+ * Storage of BASICVECTOR_HUGE_PAGE_SIZE and above is mapped with mmap at huge page alignment and marked
+ * with MADV_HUGEPAGE, so that the kernel can back it with transparent huge pages. The mapped flag of the vector
+ * records how its storage was obtained, as arrays adopted from malloc can be of any size.
+ */
+#if defined(__linux__) && !defined(BASICVECTOR_NO_MMAP)
+#define BASICVECTOR_MMAP
+#endif
+
+static inline bool basicvector_internal_should_map(size_t capacity) {
+#ifdef BASICVECTOR_MMAP
+    return capacity >= BASICVECTOR_HUGE_PAGE_SIZE / sizeof(void *);
+#else
+    (void) capacity;
+    return false;
+#endif
+}
+
+#ifdef BASICVECTOR_MMAP
+static void **basicvector_internal_map(size_t size) {
+    // Over-allocating by one huge page leaves room to trim the mapping to an aligned start
+    size_t mapped_size = size + BASICVECTOR_HUGE_PAGE_SIZE;
+    char *mapping = mmap(NULL, mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if (mapping == MAP_FAILED) {
+        return NULL;
+    }
+
+    char *aligned = (char *) (((uintptr_t) mapping + BASICVECTOR_HUGE_PAGE_SIZE - 1) & ~(uintptr_t) (BASICVECTOR_HUGE_PAGE_SIZE - 1));
+    size_t head = (size_t) (aligned - mapping);
+
+    if (head > 0) munmap(mapping, head);
+    munmap(aligned + size, mapped_size - head - size);
+
+#ifdef MADV_HUGEPAGE
+    madvise(aligned, size, MADV_HUGEPAGE);
+#endif
+
+    return (void **) aligned;
+}
+#endif
+
+/*
+ * Size of a heap allocation of given requested size, including allocator rounding where it can be queried
+ */
+static size_t basicvector_internal_usable_size(void *pointer, size_t size) {
+    if (pointer == NULL) {
+        return 0;
+    }
+
+#ifdef __GLIBC__
+    (void) size;
+    return malloc_usable_size(pointer);
+#else
+    return size;
+#endif
+}
+
+static size_t basicvector_internal_storage_bytes(void **items, size_t capacity, bool mapped) {
+    if (mapped) {
+        return sizeof(void *) * capacity;
+    }
+
+    return basicvector_internal_usable_size(items, sizeof(void *) * capacity);
+}
+
+/*
+ * Releases heap storage of given capacity, with munmap if it has been mapped and with free otherwise
+ */
+static void basicvector_internal_release(void **items, size_t capacity, bool mapped) {
+    BASICVECTOR_ACCOUNT_SUB(storage_bytes, basicvector_internal_storage_bytes(items, capacity, mapped));
+
+#ifdef BASICVECTOR_MMAP
+    if (mapped) {
+        munmap(items, sizeof(void *) * capacity);
+        return;
+    }
+#else
+    (void) capacity;
+    (void) mapped;
+#endif
+
+    free(items);
+}
+
+/*
+ * Moves items to heap storage of new_capacity items, new_capacity has to be greater than BASICVECTOR_SMALL_CAPACITY and at least vector length
+ */
+static int basicvector_internal_resize(struct basicvector_s *vector, size_t new_capacity) {
+    size_t new_size = sizeof(void *) * new_capacity;
+
+    if (new_size >= BASICVECTOR_HUGE_PAGE_SIZE && new_size <= SIZE_MAX - BASICVECTOR_HUGE_PAGE_SIZE) {
+        new_size = (new_size + BASICVECTOR_HUGE_PAGE_SIZE - 1) & ~(BASICVECTOR_HUGE_PAGE_SIZE - 1);
+        new_capacity = new_size / sizeof(void *);
+    }
+
+    if (new_capacity == vector->capacity) {
+        return BASICVECTOR_SUCCESS;
+    }
+
+    bool spilling = vector->items == vector->small_items;
+    bool was_mapped = !spilling && vector->mapped;
+    bool mapped = basicvector_internal_should_map(new_capacity);
+    void **new_items = NULL;
+
+    // Storage from malloc that is already past the mapped range, such as an adopted array, keeps growing with realloc
+    if (!spilling && !was_mapped && basicvector_internal_should_map(vector->capacity)) {
+        mapped = false;
+    }
+
+#ifdef BASICVECTOR_MMAP
+    // Mapped storage is first resized in place, which keeps its huge page alignment
+    if (was_mapped && mapped) {
+        void *remapped = mremap(vector->items, sizeof(void *) * vector->capacity, new_size, 0);
+
+        if (remapped != MAP_FAILED) {
+            BASICVECTOR_ACCOUNT_SUB(storage_bytes, sizeof(void *) * vector->capacity);
+            new_items = remapped;
+        }
+    }
+#endif
+
+    if (new_items == NULL && !spilling && !was_mapped && !mapped) {
+        BASICVECTOR_ACCOUNT_SUB(storage_bytes, basicvector_internal_storage_bytes(vector->items, vector->capacity, false));
+        new_items = realloc(vector->items, new_size);
+
+        // Failed realloc leaves the old storage in place
+        if (new_items == NULL) {
+            BASICVECTOR_ACCOUNT_ADD(storage_bytes, basicvector_internal_storage_bytes(vector->items, vector->capacity, false));
+        }
+    } else if (new_items == NULL) {
+#ifdef BASICVECTOR_MMAP
+        new_items = mapped ? basicvector_internal_map(new_size) : malloc(new_size);
+#else
+        new_items = malloc(new_size);
+#endif
+
+        if (new_items != NULL) {
+            memcpy(new_items, vector->items, sizeof(void *) * vector->length);
+
+            // Storage spills from the inline small_items buffer to the heap on first growth
+            if (!spilling) {
+                basicvector_internal_release(vector->items, vector->capacity, was_mapped);
+            }
+        }
+    }
+
+    if (new_items == NULL) {
+        return BASICVECTOR_MEMORY_ERROR;
+    }
+
+    // Growing heap storage, even in place, gives up the old block and counts as a free as well
+    BASICVECTOR_STAT_ADD(vector, mallocs, 1);
+    if (!spilling) BASICVECTOR_STAT_ADD(vector, frees, 1);
+    BASICVECTOR_ACCOUNT_ADD(storage_bytes, basicvector_internal_storage_bytes(new_items, new_capacity, mapped));
+
+    vector->items = new_items;
+    vector->capacity = new_capacity;
+    vector->mapped = mapped;
+
+    return BASICVECTOR_SUCCESS;
+}
+
+/*
+ * Makes sure that items array can hold at least required_capacity items, growing it geometrically
+ */
+static int basicvector_internal_reserve(struct basicvector_s *vector, size_t required_capacity) {
+    if (required_capacity <= vector->capacity) {
+        return BASICVECTOR_SUCCESS;
+    }
+
+    if (required_capacity > BASICVECTOR_MAX_LENGTH) {
+        return BASICVECTOR_MEMORY_ERROR;
+    }
+
+    size_t new_capacity = vector->capacity < BASICVECTOR_MIN_CAPACITY ? BASICVECTOR_MIN_CAPACITY : vector->capacity;
+
+    while (new_capacity < required_capacity) {
+        new_capacity = new_capacity > BASICVECTOR_MAX_LENGTH / 2 ? BASICVECTOR_MAX_LENGTH : new_capacity * 2;
+    }
+
+    return basicvector_internal_resize(vector, new_capacity);
+}
+
+/*
+ * Reduces items array to at least target_capacity items, moving items back into small_items when they fit
+ *
+ * Failing to shrink is not an error, the vector simply keeps its current storage.
+ */
+static void basicvector_internal_shrink(struct basicvector_s *vector, size_t target_capacity) {
+    if (vector->items == vector->small_items) {
+        return;
+    }
+
+    if (target_capacity < vector->length) target_capacity = vector->length;
+
+    if (target_capacity <= BASICVECTOR_SMALL_CAPACITY) {
+        memcpy(vector->small_items, vector->items, sizeof(void *) * vector->length);
+        basicvector_internal_release(vector->items, vector->capacity, vector->mapped);
+        BASICVECTOR_STAT_ADD(vector, frees, 1);
+
+        vector->items = vector->small_items;
+        vector->capacity = BASICVECTOR_SMALL_CAPACITY;
+        vector->mapped = false;
+
+        return;
+    }
+
+    if (target_capacity < vector->capacity) {
+        basicvector_internal_resize(vector, target_capacity);
+    }
+}
+
+static inline void basicvector_internal_occupancy_invalidate(struct basicvector_s *vector) {
+    vector->occupancy.valid = false;
+}
+
+/*
+ * Updates occupancy bit of index after previous_item has been replaced by item, bits past the end are always clear
+ */
+static inline void basicvector_internal_occupancy_assign(struct basicvector_s *vector, size_t index, void *previous_item, void *item) {
+    struct basicvector_occupancy_s *occupancy = &vector->occupancy;
+
+    if (!occupancy->valid) {
+        return;
+    }
+
+    if (index / 64 >= occupancy->word_capacity) {
+        occupancy->valid = false;
+        return;
+    }
+
+    uint64_t bit = (uint64_t) 1 << (index % 64);
+
+    if (previous_item != NULL) {
+        occupancy->words[index / 64] &= ~bit;
+        occupancy->non_null_count--;
+    }
+
+    if (item != NULL) {
+        occupancy->words[index / 64] |= bit;
+        occupancy->non_null_count++;
+    }
+}
+
+/*
+ * Updates occupancy after the item at last has been moved over removed_item at index
+ */
+static inline void basicvector_internal_occupancy_swap_remove(struct basicvector_s *vector, size_t index, size_t last, void *removed_item) {
+    struct basicvector_occupancy_s *occupancy = &vector->occupancy;
+
+    if (!occupancy->valid) {
+        return;
+    }
+
+    uint64_t index_bit = (uint64_t) 1 << (index % 64);
+    uint64_t last_bit = (uint64_t) 1 << (last % 64);
+    bool last_set = (occupancy->words[last / 64] & last_bit) != 0;
+
+    if (removed_item != NULL) occupancy->non_null_count--;
+
+    occupancy->words[index / 64] = last_set ? occupancy->words[index / 64] | index_bit : occupancy->words[index / 64] & ~index_bit;
+    occupancy->words[last / 64] &= ~last_bit;
+}
+
+/*
+ * Bloom filter of item hashes
+ *
+ * Every hash sets BASICVECTOR_FILTER_PROBES bits chosen by double hashing of its halves. The filter is sized for
+ * about BASICVECTOR_FILTER_BITS_PER_ITEM bits per item, which keeps false positives around 1%.
+ */
+#define BASICVECTOR_FILTER_PROBES 4
+#define BASICVECTOR_FILTER_BITS_PER_ITEM 10
+#define BASICVECTOR_FILTER_MIN_BITS 1024
+
+struct basicvector_filter_s {
+    uint64_t (*hash_function)(void *item, void *user_data);
+    void *user_data;
+    uint64_t *words;
+    size_t bit_mask;
+    // Hashes added since the last rebuild, including those of items removed since
+    size_t hash_count;
+    size_t sized_for;
+    bool stale;
+};
+
+static inline void basicvector_internal_filter_add_hash(struct basicvector_filter_s *filter, uint64_t hash) {
+    uint64_t first = hash;
+    uint64_t step = (hash >> 32) | 1;
+
+    for (int i = 0; i < BASICVECTOR_FILTER_PROBES; i++) {
+        size_t bit = (size_t) (first + (uint64_t) i * step) & filter->bit_mask;
+        filter->words[bit / 64] |= (uint64_t) 1 << (bit % 64);
+    }
+}
+
+static inline bool basicvector_internal_filter_may_contain(struct basicvector_filter_s *filter, uint64_t hash) {
+    uint64_t first = hash;
+    uint64_t step = (hash >> 32) | 1;
+
+    for (int i = 0; i < BASICVECTOR_FILTER_PROBES; i++) {
+        size_t bit = (size_t) (first + (uint64_t) i * step) & filter->bit_mask;
+
+        if ((filter->words[bit / 64] & ((uint64_t) 1 << (bit % 64))) == 0) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static inline void basicvector_internal_filter_add(struct basicvector_s *vector, void *item) {
+    struct basicvector_filter_s *filter = vector->filter;
+
+    // Null items, such as the gaps left by basicvector_set, are never hashed
+    if (filter == NULL || filter->stale || item == NULL) {
+        return;
+    }
+
+    // A filter filled past its size would answer "maybe" to everything, so it waits for a bigger rebuild instead
+    if (++filter->hash_count > filter->sized_for) {
+        filter->stale = true;
+        return;
+    }
+
+    basicvector_internal_filter_add_hash(filter, filter->hash_function(item, filter->user_data));
+}
+
+static inline void basicvector_internal_filter_invalidate(struct basicvector_s *vector) {
+    if (vector->filter != NULL) {
+        vector->filter->stale = true;
+    }
+}
+
+/*
+ * Slot map behind generational handles
+ *
+ * A handle is (generation << 32) | slot. A live slot holds the index of its item in the vector, a free one holds
+ * the next free slot. The generation is bumped when a slot is freed and again when it is reused, so live slots have
+ * odd generations and free ones even, which no issued handle carries. dense_slots maps item indexes back to slots, so that the last item can be moved into the
+ * place of a removed one in constant time.
+ */
+struct basicvector_internal_slot_s {
+    uint32_t index_or_next_free;
+    uint32_t generation;
+};
+
+struct basicvector_handles_s {
+    struct basicvector_internal_slot_s *slots;
+    uint32_t *dense_slots;
+    size_t slot_count;
+    size_t slot_capacity;
+    size_t dense_capacity;
+    size_t live_count;
+    uint32_t free_head;
+};
+
+#define BASICVECTOR_NO_FREE_SLOT UINT32_MAX
+
+static void basicvector_internal_handles_free(struct basicvector_handles_s *handles) {
+    if (handles == NULL) {
+        return;
+    }
+
+    free(handles->slots);
+    free(handles->dense_slots);
+    free(handles);
+}
+
+#define BASICVECTOR_DEFAULT_TOMBSTONE_THRESHOLD 0.25
+
+/*
+ * Deferred removals mark slots in a bitmap instead of shifting the items after them. Every operation other than
+ * get, length and remove_deferred flushes the marked slots first, so the storage is only rearranged in bulk
+ * and the rest of the code never sees tombstones.
+ */
+struct basicvector_tombstones_s {
+    uint64_t *words;
+    size_t word_capacity;
+    size_t count;
+    double threshold;
+    // Word reached by the last logical lookup and the number of live items before it, so that ascending lookups resume there
+    size_t cursor_word;
+    size_t cursor_live;
+};
+
+static inline bool basicvector_internal_has_tombstones(struct basicvector_s *vector) {
+    return vector->tombstones != NULL && vector->tombstones->count > 0;
+}
+
+static inline size_t basicvector_internal_logical_length(struct basicvector_s *vector) {
+    return vector->tombstones == NULL ? vector->length : vector->length - vector->tombstones->count;
+}
+
+/*
+ * Maps logical index of a live item, which has to be lower than logical length of the vector, to its slot
+ */
+static size_t basicvector_internal_tombstones_locate(struct basicvector_s *vector, size_t index) {
+    struct basicvector_tombstones_s *tombstones = vector->tombstones;
+    size_t word = 0;
+    size_t live = 0;
+
+    if (index >= tombstones->cursor_live) {
+        word = tombstones->cursor_word;
+        live = tombstones->cursor_live;
+    }
+
+    for (;; word++) {
+        size_t base = word * 64;
+        size_t slots = vector->length - base < 64 ? vector->length - base : 64;
+        uint64_t dead = tombstones->words[word];
+        size_t word_live = slots - (size_t) __builtin_popcountll(dead);
+
+        if (index < live + word_live) {
+            tombstones->cursor_word = word;
+            tombstones->cursor_live = live;
+
+            uint64_t alive = ~dead;
+
+            // Clears the lowest live bits preceding the wanted one
+            for (size_t skip = index - live; skip > 0; skip--) {
+                alive &= alive - 1;
+            }
+
+            return base + (size_t) __builtin_ctzll(alive);
+        }
+
+        live += word_live;
+    }
+}
+
+/*
+ * Drops all tombstoned slots in a single pass, moving runs of live items down as whole words where possible
+ */
+static void basicvector_internal_flush(struct basicvector_s *vector) {
+    struct basicvector_tombstones_s *tombstones = vector->tombstones;
+    size_t word_count = (vector->length + 63) / 64;
+    size_t kept = 0;
+
+    for (size_t word = 0; word < word_count; word++) {
+        size_t base = word * 64;
+        size_t slots = vector->length - base < 64 ? vector->length - base : 64;
+        uint64_t dead = tombstones->words[word];
+
+        if (dead == 0) {
+            memmove(&vector->items[kept], &vector->items[base], sizeof(void *) * slots);
+            kept += slots;
+            continue;
+        }
+
+        for (size_t bit = 0; bit < slots; bit++) {
+            if ((dead >> bit & 1) == 0) {
+                vector->items[kept++] = vector->items[base + bit];
+            }
+        }
+    }
+
+    memset(tombstones->words, 0, sizeof(uint64_t) * word_count);
+
+    BASICVECTOR_STAT_ADD(vector, remove_entries_walked, vector->length);
+
+    vector->length = kept;
+    tombstones->count = 0;
+    tombstones->cursor_word = 0;
+    tombstones->cursor_live = 0;
+
+    basicvector_internal_occupancy_invalidate(vector);
+
+    BASICVECTOR_AUTO_COMPACT_CHECK(vector);
+}
+
+static inline void basicvector_internal_settle(struct basicvector_s *vector) {
+    if (basicvector_internal_has_tombstones(vector)) {
+        basicvector_internal_flush(vector);
+    }
+}
+
+static int basicvector_internal_tombstones_init(struct basicvector_s *vector) {
+    if (vector->tombstones != NULL) {
+        return BASICVECTOR_SUCCESS;
+    }
+
+    struct basicvector_tombstones_s *tombstones = calloc(1, sizeof(struct basicvector_tombstones_s));
+
+    if (tombstones == NULL) {
+        return BASICVECTOR_MEMORY_ERROR;
+    }
+
+    tombstones->threshold = BASICVECTOR_DEFAULT_TOMBSTONE_THRESHOLD;
+    vector->tombstones = tombstones;
+
+    return BASICVECTOR_SUCCESS;
+}
+
+/*
+ * Vector structures released by basicvector_free are kept in a small per-thread cache and handed out again by
+ * basicvector_init, so that threads creating and destroying short-lived vectors do not go through malloc. Caches
+ * exchange structures with a global pool in batches of half their size, and return all of them to it when their
+ * thread exits. Building with BASICVECTOR_NO_HEADER_CACHE allocates every structure with malloc instead.
+ */
+#ifndef BASICVECTOR_NO_HEADER_CACHE
+#define BASICVECTOR_HEADER_CACHE
+#endif
+
+#ifdef BASICVECTOR_HEADER_CACHE
+#define BASICVECTOR_HEADER_CACHE_SIZE 32
+#define BASICVECTOR_HEADER_POOL_SIZE 1024
+
+struct basicvector_internal_header_cache_s {
+    struct basicvector_s *headers[BASICVECTOR_HEADER_CACHE_SIZE];
+    int count;
+    bool registered;
+};
+
+static _Thread_local struct basicvector_internal_header_cache_s basicvector_internal_header_cache;
+
+static pthread_mutex_t basicvector_internal_header_pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct basicvector_s *basicvector_internal_header_pool[BASICVECTOR_HEADER_POOL_SIZE];
+// Only changed while holding the mutex, read without it to skip locking an empty pool
+static atomic_int basicvector_internal_header_pool_count = 0;
+static pthread_key_t basicvector_internal_header_cache_key;
+static pthread_once_t basicvector_internal_header_cache_key_once = PTHREAD_ONCE_INIT;
+
+/*
+ * Moves count structures from the cache to the global pool, freeing those that do not fit into it
+ */
+static void basicvector_internal_header_cache_drain(struct basicvector_internal_header_cache_s *cache, int count) {
+    pthread_mutex_lock(&basicvector_internal_header_pool_mutex);
+
+    int pool_count = atomic_load_explicit(&basicvector_internal_header_pool_count, memory_order_relaxed);
+
+    for (; count > 0 && pool_count < BASICVECTOR_HEADER_POOL_SIZE; count--) {
+        basicvector_internal_header_pool[pool_count++] = cache->headers[--cache->count];
+    }
+
+    atomic_store_explicit(&basicvector_internal_header_pool_count, pool_count, memory_order_relaxed);
+
+    pthread_mutex_unlock(&basicvector_internal_header_pool_mutex);
+
+    for (; count > 0; count--) {
+        free(cache->headers[--cache->count]);
+    }
+}
+
+static void basicvector_internal_header_cache_exit(void *argument) {
+    struct basicvector_internal_header_cache_s *cache = argument;
+
+    basicvector_internal_header_cache_drain(cache, cache->count);
+
+    // Vectors freed by later thread destructors register the cache again
+    cache->registered = false;
+}
+
+static void basicvector_internal_header_cache_key_create() {
+    pthread_key_create(&basicvector_internal_header_cache_key, basicvector_internal_header_cache_exit);
+}
+
+static struct basicvector_s *basicvector_internal_header_alloc() {
+    struct basicvector_internal_header_cache_s *cache = &basicvector_internal_header_cache;
+
+    if (cache->count == 0 && atomic_load_explicit(&basicvector_internal_header_pool_count, memory_order_relaxed) > 0) {
+        pthread_mutex_lock(&basicvector_internal_header_pool_mutex);
+
+        int pool_count = atomic_load_explicit(&basicvector_internal_header_pool_count, memory_order_relaxed);
+
+        while (cache->count < BASICVECTOR_HEADER_CACHE_SIZE / 2 && pool_count > 0) {
+            cache->headers[cache->count++] = basicvector_internal_header_pool[--pool_count];
+        }
+
+        atomic_store_explicit(&basicvector_internal_header_pool_count, pool_count, memory_order_relaxed);
+
+        pthread_mutex_unlock(&basicvector_internal_header_pool_mutex);
+    }
+
+    if (cache->count > 0) {
+        return cache->headers[--cache->count];
+    }
+
+    return malloc(sizeof(struct basicvector_s));
+}
+
+static void basicvector_internal_header_release(struct basicvector_s *vector) {
+    struct basicvector_internal_header_cache_s *cache = &basicvector_internal_header_cache;
+
+    // Key destructors only run for threads that have set a value, so every caching thread sets it once
+    if (!cache->registered) {
+        pthread_once(&basicvector_internal_header_cache_key_once, basicvector_internal_header_cache_key_create);
+        pthread_setspecific(basicvector_internal_header_cache_key, cache);
+        cache->registered = true;
+    }
+
+    if (cache->count == BASICVECTOR_HEADER_CACHE_SIZE) {
+        basicvector_internal_header_cache_drain(cache, BASICVECTOR_HEADER_CACHE_SIZE / 2);
+    }
+
+    cache->headers[cache->count++] = vector;
+}
+#else
+static struct basicvector_s *basicvector_internal_header_alloc() {
+    return malloc(sizeof(struct basicvector_s));
+}
+
+static void basicvector_internal_header_release(struct basicvector_s *vector) {
+    free(vector);
+}
+#endif
+
+int basicvector_init_inplace(struct basicvector_s *vector) {
+    if (vector == NULL) return BASICVECTOR_MEMORY_ERROR;
+
+    vector->items = vector->small_items;
+    vector->length = 0;
+    vector->capacity = BASICVECTOR_SMALL_CAPACITY;
+    vector->mapped = false;
+    vector->handles = NULL;
+    vector->occupancy = (struct basicvector_occupancy_s) { 0 };
+    vector->filter = NULL;
+    vector->tombstones = NULL;
+
+#ifdef BASICVECTOR_STATS
+    vector->stats = (struct basicvector_stats_s) { 0 };
+#endif
+
+    return BASICVECTOR_SUCCESS;
+}
+
+int basicvector_init(struct basicvector_s **vector) {
+    struct basicvector_s *new_vector = basicvector_internal_header_alloc();
+
+    if (new_vector == NULL) {
+        return BASICVECTOR_MEMORY_ERROR;
+    }
+
+    basicvector_init_inplace(new_vector);
+
+    BASICVECTOR_STAT_ADD(new_vector, mallocs, 1);
+    BASICVECTOR_ACCOUNT_ADD(vector_count, 1);
+
+    *vector = new_vector;
+
+    return BASICVECTOR_SUCCESS;
+}
+
+int basicvector_from_array(struct basicvector_s **vector, void **items, size_t count) {
+    if (vector == NULL) return BASICVECTOR_MEMORY_ERROR;
+    if (items == NULL && count > 0) return BASICVECTOR_INVALID_ARGUMENT;
+    if (count > BASICVECTOR_MAX_LENGTH) return BASICVECTOR_MEMORY_ERROR;
+
+    struct basicvector_s *new_vector;
+
+    if (basicvector_init(&new_vector) != BASICVECTOR_SUCCESS) {
+        return BASICVECTOR_MEMORY_ERROR;
+    }
+
+    if (count > BASICVECTOR_SMALL_CAPACITY && basicvector_internal_resize(new_vector, count) != BASICVECTOR_SUCCESS) {
+        basicvector_free(new_vector, NULL, NULL);
+        return BASICVECTOR_MEMORY_ERROR;
+    }
+
+    if (count > 0) {
+        memcpy(new_vector->items, items, sizeof(void *) * count);
+    }
+
+    new_vector->length = count;
+    BASICVECTOR_STAT_PEAK(new_vector);
+
+    *vector = new_vector;
+
+    return BASICVECTOR_SUCCESS;
+}
+
+int basicvector_from_array_adopt(struct basicvector_s **vector, void **items, size_t count, size_t capacity) {
+    if (vector == NULL) return BASICVECTOR_MEMORY_ERROR;
+    if (items == NULL || capacity < count || capacity > BASICVECTOR_MAX_LENGTH) return BASICVECTOR_INVALID_ARGUMENT;
+
+    struct basicvector_s *new_vector;
+
+    if (basicvector_init(&new_vector) != BASICVECTOR_SUCCESS) {
+        return BASICVECTOR_MEMORY_ERROR;
+    }
+
+    // The array stays storage from malloc whatever its size, so it is later grown with realloc and released with free
+    new_vector->items = items;
+    new_vector->capacity = capacity;
+    new_vector->mapped = false;
+    BASICVECTOR_ACCOUNT_ADD(storage_bytes, basicvector_internal_storage_bytes(items, capacity, false));
+
+    new_vector->length = count;
+    BASICVECTOR_STAT_PEAK(new_vector);
+
+    *vector = new_vector;
+
+    return BASICVECTOR_SUCCESS;
+}
+
+static int basicvector_internal_push(struct basicvector_s *vector, void *item, size_t *walked) {
+    if (vector == NULL) return BASICVECTOR_MEMORY_ERROR;
+
+    basicvector_internal_settle(vector);
+
+    BASICVECTOR_STAT_ADD(vector, push_calls, 1);
+
+    if (basicvector_internal_reserve(vector, vector->length + 1) != BASICVECTOR_SUCCESS) {
+        return BASICVECTOR_MEMORY_ERROR;
+    }
+
+    vector->items[vector->length] = item;
+    basicvector_internal_occupancy_assign(vector, vector->length, NULL, item);
+    basicvector_internal_filter_add(vector, item);
+    vector->length++;
+    BASICVECTOR_STAT_PEAK(vector);
+
+    *walked = 0;
+
+    return BASICVECTOR_SUCCESS;
+}
+
+int basicvector_push(struct basicvector_s *vector, void *item) {
+    size_t walked = 0;
+
+    BASICVECTOR_PROBE_ENTRY(push, vector, -1);
+
+    // An item pushed past the slot table would have no slot, basicvector_insert_handle pushes on its own
+    int status = vector != NULL && vector->handles != NULL
+        ? BASICVECTOR_UNSUPPORTED
+        : basicvector_internal_push(vector, item, &walked);
+    BASICVECTOR_PROBE_RETURN(push, vector, -1, basicvector_internal_probe_length(vector), walked, status);
+
+    return status;
+}
+
+static int basicvector_internal_get(struct basicvector_s *vector, size_t index, void **result, size_t *walked) {
+    if (vector == NULL) return BASICVECTOR_MEMORY_ERROR;
+
+    BASICVECTOR_STAT_ADD(vector, get_calls, 1);
+
+    if (index >= basicvector_internal_logical_length(vector)) {
+        *result = NULL;
+        return BASICVECTOR_ITEM_NOT_FOUND;
+    }
+
+    *walked = 0;
+
+    if (basicvector_internal_has_tombstones(vector)) {
+        index = basicvector_internal_tombstones_locate(vector, index);
+    }
+
+    *result = vector->items[index];
+    return BASICVECTOR_SUCCESS;
+}
+
+int basicvector_get64(struct basicvector_s *vector, size_t index, void **result) {
+    size_t walked = 0;
+
+    BASICVECTOR_PROBE_ENTRY(get, vector, index);
+    int status = basicvector_internal_get(vector, index, result, &walked);
+    BASICVECTOR_PROBE_RETURN(get, vector, index, basicvector_internal_probe_length(vector), walked, status);
+
+    return status;
+}
+
+int basicvector_get(struct basicvector_s *vector, int index, void **result) {
+    if (vector != NULL && index < 0) {
+        *result = NULL;
+        return BASICVECTOR_ITEM_NOT_FOUND;
+    }
+
+    return basicvector_get64(vector, (size_t) index, result);
+}
+
+int basicvector_find_index64(
+    struct basicvector_s *vector,
+    size_t *result,
+    bool (*search_function)(void *item, void *user_data),
+    void *user_data
+) {
+    if (vector == NULL) return BASICVECTOR_MEMORY_ERROR;
+    if (search_function == NULL || result == NULL) return BASICVECTOR_INVALID_ARGUMENT;
+
+    basicvector_internal_settle(vector);
+
+    BASICVECTOR_STAT_ADD(vector, find_index_calls, 1);
+
+    for (size_t i = 0; i < vector->length; i++) {
+        BASICVECTOR_STAT_ADD(vector, find_index_entries_walked, 1);
+
+        if (search_function(vector->items[i], user_data)) {
+            *result = i;
+            return BASICVECTOR_SUCCESS;
+        }
+    }
+
+    return BASICVECTOR_ITEM_NOT_FOUND;
+}
+
+int basicvector_find_index(
+    struct basicvector_s *vector,
+    int *result,
+    bool (*search_function)(void *item, void *user_data),
+    void *user_data
+) {
+    if (vector != NULL && result == NULL) return BASICVECTOR_INVALID_ARGUMENT;
+
+    size_t index;
+    int status = basicvector_find_index64(vector, &index, search_function, user_data);
+
+    if (status != BASICVECTOR_SUCCESS) return status;
+    if (index > INT_MAX) return BASICVECTOR_OVERFLOW;
+
+    *result = (int) index;
+
+    return BASICVECTOR_SUCCESS;
+}
+
+static int basicvector_internal_find(
+    struct basicvector_s *vector,
+    void **result,
+    bool (*search_function)(void *item, void *user_data),
+    void *user_data,
+    size_t *walked
+) {
+    if (vector == NULL) return BASICVECTOR_MEMORY_ERROR;
+    if (result == NULL || search_function == NULL) return BASICVECTOR_INVALID_ARGUMENT;
+
+    basicvector_internal_settle(vector);
+
+    BASICVECTOR_STAT_ADD(vector, find_calls, 1);
+
+    for (size_t i = 0; i < vector->length; i++) {
+        (*walked)++;
+        BASICVECTOR_STAT_ADD(vector, find_entries_walked, 1);
+
+        if (search_function(vector->items[i], user_data)) {
+            *result = vector->items[i];
+            return BASICVECTOR_SUCCESS;
+        }
+    }
+
+    *result = NULL;
+    return BASICVECTOR_ITEM_NOT_FOUND;
+}
+
+int basicvector_find(
+    struct basicvector_s *vector,
+    void **result,
+    bool (*search_function)(void *item, void *user_data),
+    void *user_data
+) {
+    size_t walked = 0;
+
+    BASICVECTOR_PROBE_ENTRY(find, vector, -1);
+    int status = basicvector_internal_find(vector, result, search_function, user_data, &walked);
+    BASICVECTOR_PROBE_RETURN(find, vector, -1, basicvector_internal_probe_length(vector), walked, status);
+
+    return status;
+}
+
+int basicvector_length64(struct basicvector_s *vector, size_t *result) {
+    if (vector == NULL) {
+        return BASICVECTOR_MEMORY_ERROR;
+    }
+
+    if (result == NULL) return BASICVECTOR_INVALID_ARGUMENT;
+
+    BASICVECTOR_STAT_ADD(vector, length_calls, 1);
+
+    *result = basicvector_internal_logical_length(vector);
+
+    return BASICVECTOR_SUCCESS;
+}
+
+int basicvector_to_array(struct basicvector_s *vector, void **out, size_t capacity) {
+    if (vector == NULL) return BASICVECTOR_MEMORY_ERROR;
+
+    basicvector_internal_settle(vector);
+
+    if (out == NULL && vector->length > 0) return BASICVECTOR_INVALID_ARGUMENT;
+    if (capacity < vector->length) return BASICVECTOR_OVERFLOW;
+
+    if (vector->length > 0) {
+        memcpy(out, vector->items, sizeof(void *) * vector->length);
+    }
+
+    return BASICVECTOR_SUCCESS;
+}
+
+int basicvector_data(struct basicvector_s *vector, void ***result) {
+    if (vector == NULL) return BASICVECTOR_MEMORY_ERROR;
+    if (result == NULL) return BASICVECTOR_INVALID_ARGUMENT;
+
+    basicvector_internal_settle(vector);
+
+    *result = vector->items;
+
+    return BASICVECTOR_SUCCESS;
+}
+
+int basicvector_length(struct basicvector_s *vector, int *result) {
+    if (vector != NULL && result == NULL) return BASICVECTOR_INVALID_ARGUMENT;
+
+    size_t length;
+    int status = basicvector_length64(vector, &length);
+
+    if (status != BASICVECTOR_SUCCESS) return status;
+    if (length > INT_MAX) return BASICVECTOR_OVERFLOW;
+
+    *result = (int) length;
+
+    return BASICVECTOR_SUCCESS;
+}
+
+static int basicvector_internal_set(
+    struct basicvector_s *vector,
+    size_t index,
+    void *item,
+    void (*deallocation_function)(void* item, void *user_data),
+    void *user_data,
+    size_t *walked
+) {
+    if (vector == NULL) return BASICVECTOR_MEMORY_ERROR;
+
+    basicvector_internal_settle(vector);
+
+    if (index >= vector->length && vector->handles != NULL) return BASICVECTOR_UNSUPPORTED;
+
+    BASICVECTOR_STAT_ADD(vector, set_calls, 1);
+
+    if (index < vector->length) {
+        void *previous_item = vector->items[index];
+
+        if (previous_item != NULL && deallocation_function != NULL) {
+            deallocation_function(previous_item, user_data);
+        }
+
+        vector->items[index] = item;
+        basicvector_internal_occupancy_assign(vector, index, previous_item, item);
+        basicvector_internal_filter_add(vector, item);
+
+        return BASICVECTOR_SUCCESS;
+    }
+
+    if (index >= BASICVECTOR_MAX_LENGTH || basicvector_internal_reserve(vector, index + 1) != BASICVECTOR_SUCCESS) {
+        return BASICVECTOR_MEMORY_ERROR;
+    }
+
+    // Gaps between the current end and the new item are filled with null items
+    size_t gap = index - vector->length;
+
+    for (size_t i = vector->length; i < index; i++) {
+        vector->items[i] = NULL;
+    }
+
+    vector->items[index] = item;
+    basicvector_internal_occupancy_assign(vector, index, NULL, item);
+    basicvector_internal_filter_add(vector, item);
+    vector->length = index + 1;
+    BASICVECTOR_STAT_PEAK(vector);
+
+    *walked = gap;
+    BASICVECTOR_STAT_ADD(vector, set_entries_walked, gap);
+
+    return BASICVECTOR_SUCCESS;
+}
+
+int basicvector_set64(
+    struct basicvector_s *vector,
+    size_t index,
+    void *item,
+    void (*deallocation_function)(void* item, void *user_data),
+    void *user_data
+) {
+    size_t walked = 0;
+
+    BASICVECTOR_PROBE_ENTRY(set, vector, index);
+    int status = basicvector_internal_set(vector, index, item, deallocation_function, user_data, &walked);
+    BASICVECTOR_PROBE_RETURN(set, vector, index, basicvector_internal_probe_length(vector), walked, status);
+
+    return status;
+}
+
+int basicvector_set(
+    struct basicvector_s *vector,
+    int index,
+    void *item,
+    void (*deallocation_function)(void* item, void *user_data),
+    void *user_data
+) {
+    if (vector != NULL && index < 0) {
+        return BASICVECTOR_INVALID_INDEX;
+    }
+
+    return basicvector_set64(vector, (size_t) index, item, deallocation_function, user_data);
+}
+
+static int basicvector_internal_remove(
+    struct basicvector_s *vector,
+    size_t index,
+    void (*deallocation_function)(void* item, void *user_data),
+    void *user_data,
+    size_t *walked
+) {
+    if (vector == NULL) return BASICVECTOR_MEMORY_ERROR;
+
+    basicvector_internal_settle(vector);
+
+    if (index >= vector->length) {
+        return BASICVECTOR_INVALID_INDEX;
+    }
+
+    if (vector->handles != NULL) return BASICVECTOR_UNSUPPORTED;
+
+    BASICVECTOR_STAT_ADD(vector, remove_calls, 1);
+
+    void *item_to_remove = vector->items[index];
+
+    // Items after the removed one are shifted to keep the storage contiguous
+    size_t moved = vector->length - index - 1;
+
+    memmove(&vector->items[index], &vector->items[index + 1], sizeof(void *) * moved);
+
+    vector->length--;
+    basicvector_internal_occupancy_invalidate(vector);
+
+    *walked = moved;
+    BASICVECTOR_STAT_ADD(vector, remove_entries_walked, moved);
+
+    if (deallocation_function != NULL) {
+        deallocation_function(item_to_remove, user_data);
+    }
+
+    BASICVECTOR_AUTO_COMPACT_CHECK(vector);
+
+    return BASICVECTOR_SUCCESS;
+}
+
+int basicvector_remove64(
+    struct basicvector_s *vector,
+    size_t index,
+    void (*deallocation_function)(void* item, void *user_data),
+    void *user_data
+) {
+    size_t walked = 0;
+
+    BASICVECTOR_PROBE_ENTRY(remove, vector, index);
+    int status = basicvector_internal_remove(vector, index, deallocation_function, user_data, &walked);
+    BASICVECTOR_PROBE_RETURN(remove, vector, index, basicvector_internal_probe_length(vector), walked, status);
+
+    return status;
+}
+
+int basicvector_remove(
+    struct basicvector_s *vector,
+    int index,
+    void (*deallocation_function)(void* item, void *user_data),
+    void *user_data
+) {
+    if (vector != NULL && index < 0) {
+        return BASICVECTOR_INVALID_INDEX;
+    }
+
+    return basicvector_remove64(vector, (size_t) index, deallocation_function, user_data);
+}
+
+int basicvector_remove_deferred(
+    struct basicvector_s *vector,
+    size_t index,
+    void (*deallocation_function)(void *item, void *user_data),
+    void *user_data
+) {
+    if (vector == NULL) return BASICVECTOR_MEMORY_ERROR;
+    if (index >= basicvector_internal_logical_length(vector)) return BASICVECTOR_INVALID_INDEX;
+    if (vector->handles != NULL) return BASICVECTOR_UNSUPPORTED;
+
+    if (basicvector_internal_tombstones_init(vector) != BASICVECTOR_SUCCESS) {
+        return BASICVECTOR_MEMORY_ERROR;
+    }
+
+    struct basicvector_tombstones_s *tombstones = vector->tombstones;
+
+    // Nothing else changes the storage while tombstones are pending, so the bitmap is sized once per batch
+    if (tombstones->count == 0) {
+        size_t word_count = (vector->length + 63) / 64;
+
+        if (word_count > tombstones->word_capacity) {
+            uint64_t *new_words = realloc(tombstones->words, sizeof(uint64_t) * word_count);
+
+            if (new_words == NULL) {
+                return BASICVECTOR_MEMORY_ERROR;
+            }
+
+            memset(&new_words[tombstones->word_capacity], 0, sizeof(uint64_t) * (word_count - tombstones->word_capacity));
+
+            tombstones->words = new_words;
+            tombstones->word_capacity = word_count;
+        }
+    }
+
+    BASICVECTOR_STAT_ADD(vector, remove_calls, 1);
+
+    size_t slot = tombstones->count > 0 ? basicvector_internal_tombstones_locate(vector, index) : index;
+    void *item_to_remove = vector->items[slot];
+
+    tombstones->words[slot / 64] |= (uint64_t) 1 << (slot % 64);
+    tombstones->count++;
+    vector->items[slot] = NULL;
+
+    if (slot / 64 < tombstones->cursor_word) {
+        tombstones->cursor_live--;
+    }
+
+    basicvector_internal_occupancy_invalidate(vector);
+
+    if (deallocation_function != NULL) {
+        deallocation_function(item_to_remove, user_data);
+    }
+
+    if ((double) tombstones->count > tombstones->threshold * (double) vector->length) {
+        basicvector_internal_flush(vector);
+    }
+
+    return BASICVECTOR_SUCCESS;
+}
+
+int basicvector_flush(struct basicvector_s *vector) {
+    if (vector == NULL) return BASICVECTOR_MEMORY_ERROR;
+
+    basicvector_internal_settle(vector);
+
+    return BASICVECTOR_SUCCESS;
+}
+
+int basicvector_set_tombstone_threshold(struct basicvector_s *vector, double threshold) {
+    if (vector == NULL) return BASICVECTOR_MEMORY_ERROR;
+    if (!(threshold > 0.0 && threshold <= 1.0)) return BASICVECTOR_INVALID_ARGUMENT;
+
+    if (basicvector_internal_tombstones_init(vector) != BASICVECTOR_SUCCESS) {
+        return BASICVECTOR_MEMORY_ERROR;
+    }
+
+    vector->tombstones->threshold = threshold;
+
+    if ((double) vector->tombstones->count > threshold * (double) vector->length) {
+        basicvector_internal_flush(vector);
+    }
+
+    return BASICVECTOR_SUCCESS;
+}
+
+int basicvector_set_batched(
+    struct basicvector_s *vector,
+    size_t index,
+    void **items,
+    size_t count,
+    void (*dealloc_batch)(void **items, int count, void *user_data),
+    void *user_data
+) {
+    if (vector == NULL) return BASICVECTOR_MEMORY_ERROR;
+    if (items == NULL && count > 0) return BASICVECTOR_INVALID_ARGUMENT;
+    if (count == 0) return BASICVECTOR_SUCCESS;
+
+    basicvector_internal_settle(vector);
+
+    if (vector->handles != NULL && (index >= vector->length || count > vector->length - index)) return BASICVECTOR_UNSUPPORTED;
+
+    BASICVECTOR_STAT_ADD(vector, set_calls, 1);
+
+    if (index >= BASICVECTOR_MAX_LENGTH || count > BASICVECTOR_MAX_LENGTH - index) {
+        return BASICVECTOR_MEMORY_ERROR;
+    }
+
+    size_t end = index + count;
+
+    if (end > vector->length && basicvector_internal_reserve(vector, end) != BASICVECTOR_SUCCESS) {
+        return BASICVECTOR_MEMORY_ERROR;
+    }
+
+    size_t overwritten_end = end < vector->length ? end : vector->length;
+
+    if (index < overwritten_end && dealloc_batch != NULL) {
+        // Overwritten slots are reused to gather non-null previous items into a single batch
+        size_t previous_count = 0;
+
+        for (size_t i = index; i < overwritten_end; i++) {
+            if (vector->items[i] != NULL) {
+                vector->items[index + previous_count++] = vector->items[i];
+            }
+        }
+
+        basicvector_internal_dealloc_batches(&vector->items[index], previous_count, dealloc_batch, user_data);
+    }
+
+    for (size_t i = vector->length; i < index; i++) {
+        vector->items[i] = NULL;
+    }
+
+    memcpy(&vector->items[index], items, sizeof(void *) * count);
+    basicvector_internal_occupancy_invalidate(vector);
+
+    for (size_t i = 0; i < count; i++) {
+        basicvector_internal_filter_add(vector, items[i]);
+    }
+
+    if (end > vector->length) {
+        BASICVECTOR_STAT_ADD(vector, set_entries_walked, index > vector->length ? index - vector->length : 0);
+
+        vector->length = end;
+        BASICVECTOR_STAT_PEAK(vector);
+    }
+
+    return BASICVECTOR_SUCCESS;
+}
+
+int basicvector_remove_batched(
+    struct basicvector_s *vector,
+    size_t index,
+    size_t count,
+    void (*dealloc_batch)(void **items, int count, void *user_data),
+    void *user_data
+) {
+    if (vector == NULL) return BASICVECTOR_MEMORY_ERROR;
+
+    basicvector_internal_settle(vector);
+
+    if (vector->handles != NULL) return BASICVECTOR_UNSUPPORTED;
+
+    if (index >= vector->length || count > vector->length - index) {
+        return BASICVECTOR_INVALID_INDEX;
+    }
+
+    BASICVECTOR_STAT_ADD(vector, remove_calls, 1);
+
+    // Removed items are still in place, so they are passed straight from the storage before it is shifted
+    if (dealloc_batch != NULL) {
+        basicvector_internal_dealloc_batches(&vector->items[index], count, dealloc_batch, user_data);
+    }
+
+    size_t moved = vector->length - index - count;
+
+    memmove(&vector->items[index], &vector->items[index + count], sizeof(void *) * moved);
+
+    vector->length -= count;
+    basicvector_internal_occupancy_invalidate(vector);
+
+    BASICVECTOR_STAT_ADD(vector, remove_entries_walked, moved);
+    BASICVECTOR_AUTO_COMPACT_CHECK(vector);
+
+    return BASICVECTOR_SUCCESS;
+}
+
+int basicvector_swap_remove(
+    struct basicvector_s *vector,
+    size_t index,
+    void (*deallocation_function)(void *item, void *user_data),
+    void *user_data
+) {
+    if (vector == NULL) return BASICVECTOR_MEMORY_ERROR;
+
+    basicvector_internal_settle(vector);
+
+    if (index >= vector->length) return BASICVECTOR_INVALID_INDEX;
+    if (vector->handles != NULL) return BASICVECTOR_UNSUPPORTED;
+
+    BASICVECTOR_STAT_ADD(vector, remove_calls, 1);
+
+    void *item_to_remove = vector->items[index];
+
+    vector->items[index] = vector->items[vector->length - 1];
+    vector->length--;
+    basicvector_internal_occupancy_swap_remove(vector, index, vector->length, item_to_remove);
+
+    if (deallocation_function != NULL) {
+        deallocation_function(item_to_remove, user_data);
+    }
+
+    BASICVECTOR_AUTO_COMPACT_CHECK(vector);
+
+    return BASICVECTOR_SUCCESS;
+}
+
+int basicvector_swap_remove_if(
+    struct basicvector_s *vector,
+    bool (*predicate_function)(void *item, void *user_data),
+    void (*deallocation_function)(void *item, void *user_data),
+    void *user_data
+) {
+    if (vector == NULL) return BASICVECTOR_MEMORY_ERROR;
+    if (predicate_function == NULL) return BASICVECTOR_INVALID_ARGUMENT;
+    if (vector->handles != NULL) return BASICVECTOR_UNSUPPORTED;
+
+    basicvector_internal_settle(vector);
+
+    BASICVECTOR_STAT_ADD(vector, remove_calls, 1);
+
+    size_t index = 0;
+
+    // Every matching item is replaced by the last one, which is checked in turn, so each item is visited once
+    while (index < vector->length) {
+        void *item = vector->items[index];
+
+        if (!predicate_function(item, user_data)) {
+            index++;
+            continue;
+        }
+
+        vector->items[index] = vector->items[vector->length - 1];
+        vector->length--;
+        basicvector_internal_occupancy_swap_remove(vector, index, vector->length, item);
+
+        if (deallocation_function != NULL) {
+            deallocation_function(item, user_data);
+        }
+    }
+
+    BASICVECTOR_STAT_ADD(vector, remove_entries_walked, index);
+    BASICVECTOR_AUTO_COMPACT_CHECK(vector);
+
+    return BASICVECTOR_SUCCESS;
+}
+
+/*
+ * Moves item at index up until its parent does not order after it
+ */
+static void basicvector_internal_heap_sift_up(
+    void **items,
+    size_t index,
+    int arity,
+    int (*compare_function)(void *left, void *right, void *user_data),
+    void *user_data
+) {
+    void *item = items[index];
+
+    while (index > 0) {
+        size_t parent = (index - 1) / (size_t) arity;
+
+        if (compare_function(items[parent], item, user_data) <= 0) {
+            break;
+        }
+
+        items[index] = items[parent];
+        index = parent;
+    }
+
+    items[index] = item;
+}
+
+/*
+ * Moves item at index down until none of its children orders before it
+ */
+static void basicvector_internal_heap_sift_down(
+    void **items,
+    size_t length,
+    size_t index,
+    int arity,
+    int (*compare_function)(void *left, void *right, void *user_data),
+    void *user_data
+) {
+    void *item = items[index];
+
+    while (1) {
+        size_t first_child = index * (size_t) arity + 1;
+
+        if (first_child >= length || first_child <= index) {
+            break;
+        }
+
+        size_t last_child = length - first_child < (size_t) arity ? length : first_child + (size_t) arity;
+        size_t best_child = first_child;
+
+        // Children of a node are adjacent, with arity 4 and 8 byte items they share a cache line most of the time
+        for (size_t child = first_child + 1; child < last_child; child++) {
+            if (compare_function(items[child], items[best_child], user_data) < 0) {
+                best_child = child;
+            }
+        }
+
+        if (compare_function(item, items[best_child], user_data) <= 0) {
+            break;
+        }
+
+        items[index] = items[best_child];
+        index = best_child;
+    }
+
+    items[index] = item;
+}
+
+int basicvector_heapify(
+    struct basicvector_s *vector,
+    int arity,
+    int (*compare_function)(void *left, void *right, void *user_data),
+    void *user_data
+) {
+    if (vector == NULL) return BASICVECTOR_MEMORY_ERROR;
+    if (arity < 2 || compare_function == NULL) return BASICVECTOR_INVALID_ARGUMENT;
+    if (vector->handles != NULL) return BASICVECTOR_UNSUPPORTED;
+
+    basicvector_internal_settle(vector);
+
+    if (vector->length < 2) {
+        return BASICVECTOR_SUCCESS;
+    }
+
+    // Bottom-up construction sifts down every parent, starting from the last one, in O(n) overall
+    for (size_t parent = (vector->length - 2) / (size_t) arity + 1; parent > 0; parent--) {
+        basicvector_internal_heap_sift_down(vector->items, vector->length, parent - 1, arity, compare_function, user_data);
+    }
+
+    basicvector_internal_occupancy_invalidate(vector);
+
+    return BASICVECTOR_SUCCESS;
+}
+
+int basicvector_heap_push(
+    struct basicvector_s *vector,
+    void *item,
+    int arity,
+    int (*compare_function)(void *left, void *right, void *user_data),
+    void *user_data
+) {
+    if (vector == NULL) return BASICVECTOR_MEMORY_ERROR;
+    if (arity < 2 || compare_function == NULL) return BASICVECTOR_INVALID_ARGUMENT;
+    if (vector->handles != NULL) return BASICVECTOR_UNSUPPORTED;
+
+    basicvector_internal_settle(vector);
+
+    if (basicvector_push(vector, item) != BASICVECTOR_SUCCESS) {
+        return BASICVECTOR_MEMORY_ERROR;
+    }
+
+    basicvector_internal_heap_sift_up(vector->items, vector->length - 1, arity, compare_function, user_data);
+    basicvector_internal_occupancy_invalidate(vector);
+
+    return BASICVECTOR_SUCCESS;
+}
+
+int basicvector_heap_pop(
+    struct basicvector_s *vector,
+    void **result,
+    int arity,
+    int (*compare_function)(void *left, void *right, void *user_data),
+    void *user_data
+) {
+    if (vector == NULL) return BASICVECTOR_MEMORY_ERROR;
+    if (result == NULL || arity < 2 || compare_function == NULL) return BASICVECTOR_INVALID_ARGUMENT;
+    if (vector->handles != NULL) return BASICVECTOR_UNSUPPORTED;
+
+    basicvector_internal_settle(vector);
+
+    if (vector->length == 0) {
+        return BASICVECTOR_ITEM_NOT_FOUND;
+    }
+
+    BASICVECTOR_STAT_ADD(vector, remove_calls, 1);
+
+    *result = vector->items[0];
+
+    vector->length--;
+    vector->items[0] = vector->items[vector->length];
+
+    if (vector->length > 1) {
+        basicvector_internal_heap_sift_down(vector->items, vector->length, 0, arity, compare_function, user_data);
+    }
+
+    basicvector_internal_occupancy_invalidate(vector);
+    BASICVECTOR_AUTO_COMPACT_CHECK(vector);
+
+    return BASICVECTOR_SUCCESS;
+}
+
+int basicvector_heap_peek(struct basicvector_s *vector, void **result) {
+    if (vector == NULL) return BASICVECTOR_MEMORY_ERROR;
+    if (result == NULL) return BASICVECTOR_INVALID_ARGUMENT;
+
+    basicvector_internal_settle(vector);
+
+    if (vector->length == 0) {
+        return BASICVECTOR_ITEM_NOT_FOUND;
+    }
+
+    *result = vector->items[0];
+
+    return BASICVECTOR_SUCCESS;
+}
+
+int basicvector_splice(struct basicvector_s *destination, size_t index, struct basicvector_s *source) {
+    if (destination == NULL || source == NULL) return BASICVECTOR_MEMORY_ERROR;
+    if (destination == source) return BASICVECTOR_INVALID_ARGUMENT;
+
+    basicvector_internal_settle(destination);
+    basicvector_internal_settle(source);
+
+    if (index > destination->length) return BASICVECTOR_INVALID_INDEX;
+    if (destination->handles != NULL || source->handles != NULL) return BASICVECTOR_UNSUPPORTED;
+
+    size_t count = source->length;
+
+    if (count == 0) {
+        return BASICVECTOR_SUCCESS;
+    }
+
+    // Empty destination takes over heap storage of the source as a whole, nothing is copied
+    if (destination->length == 0 && source->items != source->small_items) {
+        if (destination->items != destination->small_items) {
+            basicvector_internal_release(destination->items, destination->capacity, destination->mapped);
+            BASICVECTOR_STAT_ADD(destination, frees, 1);
+        }
+
+        destination->items = source->items;
+        destination->length = count;
+        destination->capacity = source->capacity;
+        destination->mapped = source->mapped;
+        BASICVECTOR_STAT_PEAK(destination);
+
+        source->items = source->small_items;
+        source->length = 0;
+        source->capacity = BASICVECTOR_SMALL_CAPACITY;
+        source->mapped = false;
+
+        basicvector_internal_occupancy_invalidate(destination);
+        basicvector_internal_occupancy_invalidate(source);
+        basicvector_internal_filter_invalidate(destination);
+
+        return BASICVECTOR_SUCCESS;
+    }
+
+    if (count > BASICVECTOR_MAX_LENGTH - destination->length
+        || basicvector_internal_reserve(destination, destination->length + count) != BASICVECTOR_SUCCESS) {
+        return BASICVECTOR_MEMORY_ERROR;
+    }
+
+    size_t moved = destination->length - index;
+
+    memmove(&destination->items[index + count], &destination->items[index], sizeof(void *) * moved);
+    memcpy(&destination->items[index], source->items, sizeof(void *) * count);
+
+    destination->length += count;
+    BASICVECTOR_STAT_PEAK(destination);
+
+    // Source keeps its storage for reuse, only its items have been moved out
+    source->length = 0;
+
+    basicvector_internal_occupancy_invalidate(destination);
+    basicvector_internal_occupancy_invalidate(source);
+    basicvector_internal_filter_invalidate(destination);
+
+    return BASICVECTOR_SUCCESS;
+}
+
+int basicvector_append_vector(struct basicvector_s *destination, struct basicvector_s *source) {
+    if (destination == NULL) return BASICVECTOR_MEMORY_ERROR;
+
+    basicvector_internal_settle(destination);
+
+    return basicvector_splice(destination, destination->length, source);
+}
+
+int basicvector_split(struct basicvector_s *vector, size_t index, struct basicvector_s **tail) {
+    if (vector == NULL) return BASICVECTOR_MEMORY_ERROR;
+    if (tail == NULL) return BASICVECTOR_INVALID_ARGUMENT;
+
+    basicvector_internal_settle(vector);
+
+    if (index > vector->length) return BASICVECTOR_INVALID_INDEX;
+    if (vector->handles != NULL) return BASICVECTOR_UNSUPPORTED;
+
+    struct basicvector_s *new_tail;
+
+    if (basicvector_init(&new_tail) != BASICVECTOR_SUCCESS) {
+        return BASICVECTOR_MEMORY_ERROR;
+    }
+
+    size_t count = vector->length - index;
+
+    // Splitting at 0 hands the whole heap storage over to the tail, nothing is copied
+    if (index == 0 && vector->items != vector->small_items) {
+        new_tail->items = vector->items;
+        new_tail->length = count;
+        new_tail->capacity = vector->capacity;
+        new_tail->mapped = vector->mapped;
+
+        vector->items = vector->small_items;
+        vector->capacity = BASICVECTOR_SMALL_CAPACITY;
+        vector->mapped = false;
+    } else if (count > 0) {
+        if (basicvector_internal_reserve(new_tail, count) != BASICVECTOR_SUCCESS) {
+            basicvector_free(new_tail, NULL, NULL);
+            return BASICVECTOR_MEMORY_ERROR;
+        }
+
+        memcpy(new_tail->items, &vector->items[index], sizeof(void *) * count);
+        new_tail->length = count;
+    }
+
+    BASICVECTOR_STAT_PEAK(new_tail);
+    vector->length = index;
+    basicvector_internal_occupancy_invalidate(vector);
+
+    *tail = new_tail;
+
+    return BASICVECTOR_SUCCESS;
+}
+
+int basicvector_truncate(
+    struct basicvector_s *vector,
+    size_t new_length,
+    void (*deallocation_function)(void *item, void *user_data),
+    void *user_data
+) {
+    if (vector == NULL) return BASICVECTOR_MEMORY_ERROR;
+
+    basicvector_internal_settle(vector);
 
-struct basicvector_entry_s {
-    void *item;
-    struct basicvector_entry_s *next_entry;
-};
+    if (new_length > vector->length) return BASICVECTOR_INVALID_INDEX;
+    if (vector->handles != NULL) return BASICVECTOR_UNSUPPORTED;
 
-struct basicvector_entry_s* basicvector_internal_new_entry(void *item) {
-    struct basicvector_entry_s* new_entry = malloc(sizeof(struct basicvector_entry_s));
+    size_t old_length = vector->length;
 
-    if (new_entry == NULL) {
-        return NULL;
+    // Dropped items stay readable in the storage until the callbacks are done with them
+    vector->length = new_length;
+    basicvector_internal_occupancy_invalidate(vector);
+
+    if (deallocation_function != NULL) {
+        for (size_t i = new_length; i < old_length; i++) {
+            deallocation_function(vector->items[i], user_data);
+        }
     }
 
-    new_entry->item = item;
-    new_entry->next_entry = NULL;
+    BASICVECTOR_AUTO_COMPACT_CHECK(vector);
 
-    return new_entry; 
+    return BASICVECTOR_SUCCESS;
 }
 
-int basicvector_init(struct basicvector_s **vector) {
-    struct basicvector_s *new_vector = malloc(sizeof(struct basicvector_s));
-
-    if (new_vector == NULL) {
-        return BASICVECTOR_MEMORY_ERROR;
-    }
+int basicvector_compact(struct basicvector_s *vector) {
+    if (vector == NULL) return BASICVECTOR_MEMORY_ERROR;
 
-    new_vector->cached_length = 0;
-    new_vector->starting_entry = NULL;
+    basicvector_internal_settle(vector);
 
-    *vector = new_vector;
+    basicvector_internal_shrink(vector, vector->length);
 
     return BASICVECTOR_SUCCESS;
 }
 
-struct basicvector_entry_s *basicvector_internal_find_last_item(struct basicvector_s* vector) {
-    if (vector->starting_entry == NULL) {
-        return NULL;
+/*
+ * Creates slot table of the vector, giving slots to items already inside it
+ */
+static int basicvector_internal_handles_init(struct basicvector_s *vector) {
+    if (vector->length >= UINT32_MAX) {
+        return BASICVECTOR_UNSUPPORTED;
     }
 
-    struct basicvector_entry_s *examined_entry = vector->starting_entry;
+    struct basicvector_handles_s *handles = calloc(1, sizeof(struct basicvector_handles_s));
 
-    while (1) {
-        if (examined_entry->next_entry == NULL) {
-            return examined_entry;
-        }
+    if (handles == NULL) {
+        return BASICVECTOR_MEMORY_ERROR;
+    }
+
+    size_t capacity = vector->length < BASICVECTOR_MIN_CAPACITY ? BASICVECTOR_MIN_CAPACITY : vector->length;
+
+    handles->slots = malloc(sizeof(struct basicvector_internal_slot_s) * capacity);
+    handles->dense_slots = malloc(sizeof(uint32_t) * capacity);
+
+    if (handles->slots == NULL || handles->dense_slots == NULL) {
+        basicvector_internal_handles_free(handles);
+        return BASICVECTOR_MEMORY_ERROR;
+    }
 
-        examined_entry = examined_entry->next_entry;
+    for (size_t i = 0; i < vector->length; i++) {
+        handles->slots[i] = (struct basicvector_internal_slot_s) { .index_or_next_free = (uint32_t) i, .generation = 1 };
+        handles->dense_slots[i] = (uint32_t) i;
     }
 
-    return examined_entry;
+    handles->slot_count = vector->length;
+    handles->slot_capacity = capacity;
+    handles->dense_capacity = capacity;
+    handles->live_count = vector->length;
+    handles->free_head = BASICVECTOR_NO_FREE_SLOT;
+
+    vector->handles = handles;
+
+    return BASICVECTOR_SUCCESS;
 }
 
-int basicvector_push(struct basicvector_s *vector, void *item) {
+int basicvector_insert_handle(struct basicvector_s *vector, void *item, uint64_t *handle) {
     if (vector == NULL) return BASICVECTOR_MEMORY_ERROR;
+    if (handle == NULL) return BASICVECTOR_INVALID_ARGUMENT;
 
-    struct basicvector_entry_s *entry = malloc(sizeof(struct basicvector_entry_s));
+    basicvector_internal_settle(vector);
 
-    if (entry == NULL) {
-        return BASICVECTOR_MEMORY_ERROR;
+    if (vector->handles == NULL) {
+        int status = basicvector_internal_handles_init(vector);
+
+        if (status != BASICVECTOR_SUCCESS) return status;
+    }
+
+    struct basicvector_handles_s *handles = vector->handles;
+
+    if (handles->live_count != vector->length) return BASICVECTOR_UNSUPPORTED;
+    if (vector->length >= UINT32_MAX - 1) return BASICVECTOR_UNSUPPORTED;
+
+    // Both tables are grown before anything changes, so a failed allocation leaves the vector untouched
+    if (handles->live_count == handles->dense_capacity) {
+        uint32_t *dense_slots = realloc(handles->dense_slots, sizeof(uint32_t) * handles->dense_capacity * 2);
+
+        if (dense_slots == NULL) return BASICVECTOR_MEMORY_ERROR;
+
+        handles->dense_slots = dense_slots;
+        handles->dense_capacity *= 2;
+    }
+
+    if (handles->free_head == BASICVECTOR_NO_FREE_SLOT && handles->slot_count == handles->slot_capacity) {
+        struct basicvector_internal_slot_s *slots = realloc(handles->slots, sizeof(struct basicvector_internal_slot_s) * handles->slot_capacity * 2);
+
+        if (slots == NULL) return BASICVECTOR_MEMORY_ERROR;
+
+        handles->slots = slots;
+        handles->slot_capacity *= 2;
     }
 
-    vector->cached_length++;
+    size_t walked = 0;
 
-    entry->item = item;
-    entry->next_entry = NULL;
+    if (basicvector_internal_push(vector, item, &walked) != BASICVECTOR_SUCCESS) {
+        return BASICVECTOR_MEMORY_ERROR;
+    }
 
-    struct basicvector_entry_s *last_entry = basicvector_internal_find_last_item(vector);
+    uint32_t slot;
 
-    if (last_entry == NULL) {
-        vector->starting_entry = entry;
+    if (handles->free_head != BASICVECTOR_NO_FREE_SLOT) {
+        slot = handles->free_head;
+        handles->free_head = handles->slots[slot].index_or_next_free;
+        handles->slots[slot].generation++;
     } else {
-        last_entry->next_entry = entry;
+        slot = (uint32_t) handles->slot_count++;
+        handles->slots[slot].generation = 1;
     }
 
+    uint32_t index = (uint32_t) (vector->length - 1);
+
+    handles->slots[slot].index_or_next_free = index;
+    handles->dense_slots[index] = slot;
+    handles->live_count++;
+
+    *handle = ((uint64_t) handles->slots[slot].generation << 32) | slot;
+
     return BASICVECTOR_SUCCESS;
 }
 
-int basicvector_get(struct basicvector_s *vector, int index, void **result) {
-    if (vector == NULL) return BASICVECTOR_MEMORY_ERROR;
-    
-    if (index > vector->cached_length - 1) {
-        *result = NULL;
-        return BASICVECTOR_ITEM_NOT_FOUND;
+/*
+ * Finds item index of the live slot referenced by handle, returns false for stale or unknown handles
+ */
+static bool basicvector_internal_handle_index(struct basicvector_s *vector, uint64_t handle, uint32_t *index) {
+    struct basicvector_handles_s *handles = vector->handles;
+    uint32_t slot = (uint32_t) handle;
+    uint32_t generation = (uint32_t) (handle >> 32);
+
+    // Generation of a slot is bumped whenever its item is removed, so handles issued before never match again,
+    // and even generations belong to free slots, whose index_or_next_free is not an item index
+    if (handles == NULL || slot >= handles->slot_count || generation % 2 == 0 || handles->slots[slot].generation != generation) {
+        return false;
     }
 
-    struct basicvector_entry_s *entry = vector->starting_entry;
+    *index = handles->slots[slot].index_or_next_free;
+
+    return *index < vector->length;
+}
+
+int basicvector_get_handle(struct basicvector_s *vector, uint64_t handle, void **result) {
+    if (vector == NULL) return BASICVECTOR_MEMORY_ERROR;
+    if (result == NULL) return BASICVECTOR_INVALID_ARGUMENT;
 
-    for (int i = 1; i <= index; i++) {
-        entry = entry->next_entry;
+    uint32_t index;
+
+    if (!basicvector_internal_handle_index(vector, handle, &index)) {
+        return BASICVECTOR_ITEM_NOT_FOUND;
     }
 
-    *result = entry->item;
+    *result = vector->items[index];
+
     return BASICVECTOR_SUCCESS;
 }
 
-int basicvector_find_index(
+int basicvector_remove_handle(
     struct basicvector_s *vector,
-    int *result,
-    bool (*search_function)(void *item, void *user_data),
+    uint64_t handle,
+    void (*deallocation_function)(void *item, void *user_data),
     void *user_data
 ) {
     if (vector == NULL) return BASICVECTOR_MEMORY_ERROR;
-    if (search_function == NULL || result == NULL) return BASICVECTOR_INVALID_ARGUMENT;
 
-    if (vector->starting_entry == NULL) {
-        return BASICVECTOR_ITEM_NOT_FOUND;
-    }
+    struct basicvector_handles_s *handles = vector->handles;
+    uint32_t index;
 
-    int i = 0;
-    struct basicvector_entry_s *examined_entry = vector->starting_entry;
+    if (!basicvector_internal_handle_index(vector, handle, &index)) return BASICVECTOR_ITEM_NOT_FOUND;
+    if (handles->live_count != vector->length) return BASICVECTOR_UNSUPPORTED;
 
-    while (examined_entry != NULL) {
-        if (search_function(examined_entry->item, user_data)) {
-            *result = i;
-            return BASICVECTOR_SUCCESS;
-        }
+    uint32_t slot = (uint32_t) handle;
+    void *item_to_remove = vector->items[index];
+    uint32_t last = (uint32_t) (vector->length - 1);
+
+    // The last item fills the hole, so items stay dense and nothing else moves
+    vector->items[index] = vector->items[last];
+    handles->dense_slots[index] = handles->dense_slots[last];
+    handles->slots[handles->dense_slots[index]].index_or_next_free = index;
+    vector->length--;
+    basicvector_internal_occupancy_swap_remove(vector, index, last, item_to_remove);
+    handles->live_count--;
+
+    // Wraps from UINT32_MAX to 0, which keeps the parity of live and free slots
+    handles->slots[slot].generation++;
+    handles->slots[slot].index_or_next_free = handles->free_head;
+    handles->free_head = slot;
 
-        examined_entry = examined_entry->next_entry;
-        i++;
+    BASICVECTOR_STAT_ADD(vector, remove_calls, 1);
+
+    if (deallocation_function != NULL) {
+        deallocation_function(item_to_remove, user_data);
     }
 
-    return BASICVECTOR_ITEM_NOT_FOUND;
+    return BASICVECTOR_SUCCESS;
 }
 
-int basicvector_find(
-    struct basicvector_s *vector, 
-    void **result,
-    bool (*search_function)(void *item, void *user_data),
-    void *user_data
-) {
-    if (vector == NULL) return BASICVECTOR_MEMORY_ERROR;
-    if (result == NULL || search_function == NULL) return BASICVECTOR_INVALID_ARGUMENT;
+/*
+ * Rebuilds the occupancy bitmap from the items, if an operation has invalidated it or it has not been built yet
+ */
+static int basicvector_internal_occupancy_build(struct basicvector_s *vector) {
+    struct basicvector_occupancy_s *occupancy = &vector->occupancy;
 
-    if (vector->starting_entry == NULL) {
-        *result = NULL;
-        return BASICVECTOR_ITEM_NOT_FOUND;
+    if (occupancy->valid) {
+        return BASICVECTOR_SUCCESS;
     }
 
-    struct basicvector_entry_s *examined_entry = vector->starting_entry;
+    size_t word_count = (vector->length + 63) / 64;
 
-    while (examined_entry != NULL) {
-        if (search_function(examined_entry->item, user_data)) {
-            *result = examined_entry->item;
-            return BASICVECTOR_SUCCESS;
+    // Spare words let pushes keep the bitmap up to date for a while
+    if (word_count >= occupancy->word_capacity) {
+        size_t word_capacity = word_count * 2 < 4 ? 4 : word_count * 2;
+        uint64_t *words = realloc(occupancy->words, sizeof(uint64_t) * word_capacity);
+
+        if (words == NULL) {
+            return BASICVECTOR_MEMORY_ERROR;
         }
 
-        examined_entry = examined_entry->next_entry;
+        occupancy->words = words;
+        occupancy->word_capacity = word_capacity;
     }
 
-    *result = NULL;
-    return BASICVECTOR_ITEM_NOT_FOUND;
-}
+    memset(occupancy->words, 0, sizeof(uint64_t) * occupancy->word_capacity);
+    occupancy->non_null_count = 0;
 
-int basicvector_length(struct basicvector_s *vector, int *result) {
-    if (vector == NULL) {
-        return BASICVECTOR_MEMORY_ERROR;
+    for (size_t i = 0; i < vector->length; i++) {
+        if (vector->items[i] != NULL) {
+            occupancy->words[i / 64] |= (uint64_t) 1 << (i % 64);
+            occupancy->non_null_count++;
+        }
     }
 
+    occupancy->valid = true;
+
+    return BASICVECTOR_SUCCESS;
+}
+
+int basicvector_count_non_null(struct basicvector_s *vector, size_t *result) {
+    if (vector == NULL) return BASICVECTOR_MEMORY_ERROR;
     if (result == NULL) return BASICVECTOR_INVALID_ARGUMENT;
 
-    *result = vector->cached_length;
+    basicvector_internal_settle(vector);
+
+    if (basicvector_internal_occupancy_build(vector) != BASICVECTOR_SUCCESS) {
+        return BASICVECTOR_MEMORY_ERROR;
+    }
+
+    *result = vector->occupancy.non_null_count;
 
     return BASICVECTOR_SUCCESS;
 }
 
-int basicvector_set(
-    struct basicvector_s *vector, 
-    int index,
-    void *item,
-    void (*deallocation_function)(void* item, void *user_data),
-    void *user_data
-) {
+int basicvector_next_non_null(struct basicvector_s *vector, size_t from, size_t *index) {
     if (vector == NULL) return BASICVECTOR_MEMORY_ERROR;
+    if (index == NULL) return BASICVECTOR_INVALID_ARGUMENT;
 
-    if (index < 0) {
-        return BASICVECTOR_INVALID_INDEX;
+    basicvector_internal_settle(vector);
+
+    if (from >= vector->length) {
+        return BASICVECTOR_ITEM_NOT_FOUND;
     }
 
-    if (index == 0) {
-        struct basicvector_entry_s *entry_to_affect = vector->starting_entry;
+    if (basicvector_internal_occupancy_build(vector) != BASICVECTOR_SUCCESS) {
+        return BASICVECTOR_MEMORY_ERROR;
+    }
 
-        if (entry_to_affect == NULL) {
-            vector->starting_entry = basicvector_internal_new_entry(item);
+    size_t word_count = (vector->length + 63) / 64;
+    size_t word_index = from / 64;
 
-            if (vector->starting_entry == NULL) {
-                return BASICVECTOR_MEMORY_ERROR;
-            }
+    // Bits before from are masked out of the first word, bits past the end are always clear
+    uint64_t word = vector->occupancy.words[word_index] & (~(uint64_t) 0 << (from % 64));
 
-            vector->cached_length++;
-        } else {
-            if (deallocation_function != NULL) {
-                deallocation_function(entry_to_affect->item, user_data);
-            }
-            entry_to_affect->item = item;
+    while (word == 0) {
+        if (++word_index >= word_count) {
+            return BASICVECTOR_ITEM_NOT_FOUND;
         }
 
-        return BASICVECTOR_SUCCESS;
+        word = vector->occupancy.words[word_index];
+    }
+
+    *index = word_index * 64 + (size_t) __builtin_ctzll(word);
+
+    return BASICVECTOR_SUCCESS;
+}
+
+/*
+ * Rebuilds the filter from all items of the vector, sized for twice as many items to leave room for pushes
+ */
+static int basicvector_internal_filter_rebuild(struct basicvector_s *vector) {
+    struct basicvector_filter_s *filter = vector->filter;
+    size_t bit_count = BASICVECTOR_FILTER_MIN_BITS;
+
+    while (bit_count / BASICVECTOR_FILTER_BITS_PER_ITEM < vector->length * 2 && bit_count < SIZE_MAX / 4) {
+        bit_count *= 2;
     }
 
-    if (vector->starting_entry == NULL) {
-        vector->starting_entry = basicvector_internal_new_entry(NULL);
+    if (bit_count - 1 != filter->bit_mask) {
+        uint64_t *words = realloc(filter->words, bit_count / 8);
 
-        if (vector->starting_entry == NULL) {
+        if (words == NULL) {
             return BASICVECTOR_MEMORY_ERROR;
         }
 
-        vector->cached_length++;
+        filter->words = words;
+        filter->bit_mask = bit_count - 1;
+    }
+
+    memset(filter->words, 0, bit_count / 8);
+    filter->hash_count = 0;
 
+    for (size_t i = 0; i < vector->length; i++) {
+        if (vector->items[i] != NULL) {
+            basicvector_internal_filter_add_hash(filter, filter->hash_function(vector->items[i], filter->user_data));
+            filter->hash_count++;
+        }
     }
 
-    struct basicvector_entry_s *examined_entry = vector->starting_entry;
+    filter->sized_for = bit_count / BASICVECTOR_FILTER_BITS_PER_ITEM;
+    filter->stale = false;
 
-    int i = 0;
+    return BASICVECTOR_SUCCESS;
+}
 
-    while (i != index) {
-        i++;
+int basicvector_filter_enable(
+    struct basicvector_s *vector,
+    uint64_t (*hash_function)(void *item, void *user_data),
+    void *user_data
+) {
+    if (vector == NULL) return BASICVECTOR_MEMORY_ERROR;
+    if (hash_function == NULL) return BASICVECTOR_INVALID_ARGUMENT;
 
-        if (examined_entry->next_entry == NULL) {
-            examined_entry->next_entry = basicvector_internal_new_entry(NULL);
+    basicvector_internal_settle(vector);
 
-            if (examined_entry->next_entry == NULL) {
-                return BASICVECTOR_MEMORY_ERROR;
-            }
+    if (vector->filter == NULL) {
+        vector->filter = calloc(1, sizeof(struct basicvector_filter_s));
 
-            vector->cached_length++;
+        if (vector->filter == NULL) {
+            return BASICVECTOR_MEMORY_ERROR;
         }
-
-        examined_entry = examined_entry->next_entry;
     }
 
-    if (examined_entry->item != NULL && deallocation_function != NULL) {
-        deallocation_function(examined_entry->item, user_data);
+    vector->filter->hash_function = hash_function;
+    vector->filter->user_data = user_data;
+
+    if (basicvector_internal_filter_rebuild(vector) != BASICVECTOR_SUCCESS) {
+        basicvector_filter_disable(vector);
+        return BASICVECTOR_MEMORY_ERROR;
     }
 
-    examined_entry->item = item;
+    return BASICVECTOR_SUCCESS;
+}
+
+int basicvector_filter_disable(struct basicvector_s *vector) {
+    if (vector == NULL) return BASICVECTOR_MEMORY_ERROR;
+
+    if (vector->filter != NULL) {
+        free(vector->filter->words);
+        free(vector->filter);
+        vector->filter = NULL;
+    }
 
     return BASICVECTOR_SUCCESS;
 }
 
-int basicvector_remove(
-    struct basicvector_s *vector, 
-    int index, 
-    void (*deallocation_function)(void* item, void *user_data),
+int basicvector_find_by_hash(
+    struct basicvector_s *vector,
+    void **result,
+    uint64_t hash,
+    bool (*search_function)(void *item, void *user_data),
     void *user_data
 ) {
     if (vector == NULL) return BASICVECTOR_MEMORY_ERROR;
+    if (result == NULL || search_function == NULL) return BASICVECTOR_INVALID_ARGUMENT;
 
-    int length = vector->cached_length;
-    
-    if (index < 0 || index + 1 > length) {
-        return BASICVECTOR_INVALID_INDEX;
+    basicvector_internal_settle(vector);
+
+    struct basicvector_filter_s *filter = vector->filter;
+
+    if (filter != NULL && (filter->stale || filter->hash_count > vector->length * 2)) {
+        // A failed rebuild leaves the filter stale, lookups then fall back to scanning
+        basicvector_internal_filter_rebuild(vector);
     }
 
-    if (index == 0) {
-        struct basicvector_entry_s *entry_to_affect = vector->starting_entry;
+    if (filter != NULL && !filter->stale && !basicvector_internal_filter_may_contain(filter, hash)) {
+        BASICVECTOR_STAT_ADD(vector, find_calls, 1);
 
-        if (entry_to_affect == NULL) {
-            return BASICVECTOR_INVALID_INDEX;
-        }
+        *result = NULL;
+        return BASICVECTOR_ITEM_NOT_FOUND;
+    }
 
-        if (deallocation_function != NULL) {
-            deallocation_function(entry_to_affect->item, user_data);
-        }
+    return basicvector_find(vector, result, search_function, user_data);
+}
 
-        vector->starting_entry = entry_to_affect->next_entry;
+int basicvector_advise(struct basicvector_s *vector, int advice) {
+    if (vector == NULL) return BASICVECTOR_MEMORY_ERROR;
+
+    basicvector_internal_settle(vector);
 
-        free(entry_to_affect);
+#ifdef __linux__
+    int madvise_advice;
 
-        vector->cached_length--;
+    switch (advice) {
+        case BASICVECTOR_ADVICE_NORMAL: madvise_advice = MADV_NORMAL; break;
+        case BASICVECTOR_ADVICE_SEQUENTIAL: madvise_advice = MADV_SEQUENTIAL; break;
+        case BASICVECTOR_ADVICE_RANDOM: madvise_advice = MADV_RANDOM; break;
+        case BASICVECTOR_ADVICE_WILLNEED: madvise_advice = MADV_WILLNEED; break;
+        case BASICVECTOR_ADVICE_DONTNEED: madvise_advice = MADV_DONTNEED; break;
+        default: return BASICVECTOR_INVALID_ARGUMENT;
+    }
 
+    // Inline storage lives inside the vector structure, there are no pages of its own to advise on
+    if (vector->items == vector->small_items) {
         return BASICVECTOR_SUCCESS;
     }
 
-    struct basicvector_entry_s *entry_before = vector->starting_entry;
+    uintptr_t page_size = (uintptr_t) sysconf(_SC_PAGESIZE);
+    uintptr_t begin;
+    uintptr_t end;
 
-    int i = 0;
+    if (advice == BASICVECTOR_ADVICE_DONTNEED) {
+        // Dropped pages read back as zeros, so only whole pages past the last item are released
+        begin = ((uintptr_t) (vector->items + vector->length) + page_size - 1) & ~(page_size - 1);
+        end = (uintptr_t) (vector->items + vector->capacity) & ~(page_size - 1);
+    } else {
+        begin = (uintptr_t) vector->items & ~(page_size - 1);
+        end = ((uintptr_t) (vector->items + vector->length) + page_size - 1) & ~(page_size - 1);
+    }
 
-    while (i < index - 1) {
-        i++;
+    if (end <= begin) {
+        return BASICVECTOR_SUCCESS;
+    }
 
-        if (entry_before->next_entry == NULL) {
-            return BASICVECTOR_INVALID_INDEX;
-        }
+    if (madvise((void *) begin, end - begin, madvise_advice) != 0) {
+        return BASICVECTOR_UNSUPPORTED;
+    }
+
+    return BASICVECTOR_SUCCESS;
+#else
+    (void) advice;
+
+    return BASICVECTOR_UNSUPPORTED;
+#endif
+}
 
-        entry_before = entry_before->next_entry;
+int basicvector_free_inplace(struct basicvector_s *vector, void (*deallocation_function)(void *item, void *user_data), void *user_data) {
+    if (vector == NULL) {
+        return BASICVECTOR_MEMORY_ERROR;
     }
 
-    struct basicvector_entry_s *entry_to_remove = entry_before->next_entry;
+    basicvector_internal_settle(vector);
 
-    if (entry_to_remove == NULL) {
-        return BASICVECTOR_INVALID_INDEX;
+    if (deallocation_function != NULL) {
+        for (size_t i = 0; i < vector->length; i++) {
+            deallocation_function(vector->items[i], user_data);
+        }
     }
 
-    struct basicvector_entry_s *entry_after = entry_to_remove->next_entry;
+    if (vector->items != vector->small_items) {
+        basicvector_internal_release(vector->items, vector->capacity, vector->mapped);
+        BASICVECTOR_STAT_ADD(vector, frees, 1);
+    }
 
-    entry_before->next_entry = entry_after;
+    basicvector_internal_handles_free(vector->handles);
+    free(vector->occupancy.words);
+    basicvector_filter_disable(vector);
 
-    if (deallocation_function != NULL) {
-        deallocation_function(entry_to_remove->item, user_data);
+    if (vector->tombstones != NULL) {
+        free(vector->tombstones->words);
+        free(vector->tombstones);
     }
-    
-    free(entry_to_remove);
 
-    vector->cached_length--;
+    vector->items = vector->small_items;
+    vector->length = 0;
+    vector->capacity = BASICVECTOR_SMALL_CAPACITY;
+    vector->mapped = false;
+    vector->handles = NULL;
+    vector->occupancy = (struct basicvector_occupancy_s) { 0 };
+    vector->tombstones = NULL;
 
     return BASICVECTOR_SUCCESS;
 }
@@ -319,21 +2218,178 @@ int basicvector_free(struct basicvector_s *vector, void (*deallocation_function)
         return BASICVECTOR_MEMORY_ERROR;
     }
 
-    struct basicvector_entry_s* entry = vector->starting_entry;
+    BASICVECTOR_PROBE_ENTRY(free, vector, -1);
 
-    while (entry != NULL) {
-        struct basicvector_entry_s *next_entry = entry->next_entry;
+    size_t length = basicvector_internal_logical_length(vector);
 
-        if (deallocation_function != NULL) {
-            deallocation_function(entry->item, user_data);
+    basicvector_free_inplace(vector, deallocation_function, user_data);
+    basicvector_internal_header_release(vector);
+    BASICVECTOR_ACCOUNT_SUB(vector_count, 1);
+
+    // The vector is gone at this point, so only its former address and length are reported
+    BASICVECTOR_PROBE_RETURN(free, vector, -1, length, length, BASICVECTOR_SUCCESS);
+
+    return BASICVECTOR_SUCCESS;
+}
+
+int basicvector_free_batched(struct basicvector_s *vector, void (*dealloc_batch)(void **items, int count, void *user_data), void *user_data) {
+    if (vector == NULL) {
+        return BASICVECTOR_MEMORY_ERROR;
+    }
+
+    BASICVECTOR_PROBE_ENTRY(free, vector, -1);
+
+    basicvector_internal_settle(vector);
+
+    size_t length = vector->length;
+
+    if (dealloc_batch != NULL) {
+        basicvector_internal_dealloc_batches(vector->items, length, dealloc_batch, user_data);
+    }
+
+    basicvector_free_inplace(vector, NULL, NULL);
+    basicvector_internal_header_release(vector);
+    BASICVECTOR_ACCOUNT_SUB(vector_count, 1);
+
+    BASICVECTOR_PROBE_RETURN(free, vector, -1, length, length, BASICVECTOR_SUCCESS);
+
+    return BASICVECTOR_SUCCESS;
+}
+
+struct basicvector_free_handle_s {
+    struct basicvector_s *vector;
+    void (*deallocation_function)(void *item, void *user_data);
+    void *user_data;
+    size_t next_index;
+};
+
+int basicvector_free_begin(
+    struct basicvector_s *vector,
+    struct basicvector_free_handle_s **handle,
+    void (*deallocation_function)(void *item, void *user_data),
+    void *user_data
+) {
+    if (vector == NULL) return BASICVECTOR_MEMORY_ERROR;
+    if (handle == NULL) return BASICVECTOR_INVALID_ARGUMENT;
+
+    basicvector_internal_settle(vector);
+
+    struct basicvector_free_handle_s *new_handle = malloc(sizeof(struct basicvector_free_handle_s));
+
+    if (new_handle == NULL) {
+        return BASICVECTOR_MEMORY_ERROR;
+    }
+
+    new_handle->vector = vector;
+    new_handle->deallocation_function = deallocation_function;
+    new_handle->user_data = user_data;
+    new_handle->next_index = 0;
+
+    *handle = new_handle;
+
+    return BASICVECTOR_SUCCESS;
+}
+
+int basicvector_free_step(struct basicvector_free_handle_s *handle, size_t budget_items, size_t *remaining) {
+    if (handle == NULL) return BASICVECTOR_MEMORY_ERROR;
+    if (remaining == NULL) return BASICVECTOR_INVALID_ARGUMENT;
+
+    struct basicvector_s *vector = handle->vector;
+    size_t step_end = vector->length - handle->next_index < budget_items ? vector->length : handle->next_index + budget_items;
+
+    if (handle->deallocation_function != NULL) {
+        for (size_t i = handle->next_index; i < step_end; i++) {
+            handle->deallocation_function(vector->items[i], handle->user_data);
         }
+    }
 
-        free(entry);
+    handle->next_index = step_end;
+    *remaining = vector->length - step_end;
 
-        entry = next_entry;
+    // Storage is released in the step deallocating the last items, which also ends the handle
+    if (*remaining == 0) {
+        basicvector_free(vector, NULL, NULL);
+        free(handle);
     }
 
-    free(vector);
+    return BASICVECTOR_SUCCESS;
+}
+
+int basicvector_memory_usage(struct basicvector_s *vector, struct basicvector_memory_usage_s *result) {
+    if (vector == NULL) return BASICVECTOR_MEMORY_ERROR;
+    if (result == NULL) return BASICVECTOR_INVALID_ARGUMENT;
+
+    struct basicvector_memory_usage_s usage = {
+        .header_bytes = sizeof(struct basicvector_s),
+        .item_count = basicvector_internal_logical_length(vector),
+        .vector_count = 1,
+    };
+
+    if (vector->items != vector->small_items) {
+        usage.storage_bytes = basicvector_internal_storage_bytes(vector->items, vector->capacity, vector->mapped);
+        usage.slack_bytes = usage.storage_bytes - sizeof(void *) * usage.item_count;
+    }
+
+    struct basicvector_handles_s *handles = vector->handles;
+
+    if (handles != NULL) {
+        usage.auxiliary_bytes += basicvector_internal_usable_size(handles, sizeof(struct basicvector_handles_s))
+            + basicvector_internal_usable_size(handles->slots, sizeof(struct basicvector_internal_slot_s) * handles->slot_capacity)
+            + basicvector_internal_usable_size(handles->dense_slots, sizeof(uint32_t) * handles->dense_capacity);
+    }
+
+    usage.auxiliary_bytes += basicvector_internal_usable_size(vector->occupancy.words, sizeof(uint64_t) * vector->occupancy.word_capacity);
+
+    struct basicvector_filter_s *filter = vector->filter;
+
+    if (filter != NULL) {
+        usage.auxiliary_bytes += basicvector_internal_usable_size(filter, sizeof(struct basicvector_filter_s))
+            + basicvector_internal_usable_size(filter->words, (filter->bit_mask + 1) / 8);
+    }
+
+    struct basicvector_tombstones_s *tombstones = vector->tombstones;
+
+    if (tombstones != NULL) {
+        usage.auxiliary_bytes += basicvector_internal_usable_size(tombstones, sizeof(struct basicvector_tombstones_s))
+            + basicvector_internal_usable_size(tombstones->words, sizeof(uint64_t) * tombstones->word_capacity);
+    }
+
+    usage.total_bytes = usage.header_bytes + usage.storage_bytes + usage.auxiliary_bytes;
+
+    *result = usage;
+
+    return BASICVECTOR_SUCCESS;
+}
+
+int basicvector_memory_usage_total(struct basicvector_memory_usage_s *result) {
+    if (result == NULL) return BASICVECTOR_INVALID_ARGUMENT;
+
+#ifdef BASICVECTOR_ACCOUNTING
+    size_t vector_count = atomic_load_explicit(&basicvector_internal_accounted_vector_count, memory_order_relaxed);
+
+    *result = (struct basicvector_memory_usage_s) {
+        .header_bytes = sizeof(struct basicvector_s) * vector_count,
+        .storage_bytes = atomic_load_explicit(&basicvector_internal_accounted_storage_bytes, memory_order_relaxed),
+        .vector_count = vector_count,
+    };
+
+    result->total_bytes = result->header_bytes + result->storage_bytes;
+
+    return BASICVECTOR_SUCCESS;
+#else
+    return BASICVECTOR_UNSUPPORTED;
+#endif
+}
+
+int basicvector_stats(struct basicvector_s *vector, struct basicvector_stats_s *result) {
+    if (vector == NULL) return BASICVECTOR_MEMORY_ERROR;
+    if (result == NULL) return BASICVECTOR_INVALID_ARGUMENT;
+
+#ifdef BASICVECTOR_STATS
+    *result = vector->stats;
 
     return BASICVECTOR_SUCCESS;
+#else
+    return BASICVECTOR_UNSUPPORTED;
+#endif
 }
@@ -6,10 +6,143 @@
 #define BASICVECTOR_ITEM_NOT_FOUND -2
 #define BASICVECTOR_INVALID_INDEX -3
 #define BASICVECTOR_INVALID_ARGUMENT -4
+#define BASICVECTOR_UNSUPPORTED -5
+#define BASICVECTOR_OVERFLOW -6
+
+#define BASICVECTOR_ADVICE_NORMAL 0
+#define BASICVECTOR_ADVICE_SEQUENTIAL 1
+#define BASICVECTOR_ADVICE_RANDOM 2
+#define BASICVECTOR_ADVICE_WILLNEED 3
+#define BASICVECTOR_ADVICE_DONTNEED 4
+
+#define BASICVECTOR_HEAP_BINARY 2
+#define BASICVECTOR_HEAP_QUATERNARY 4
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Number of items stored directly inside the vector structure before storage spills to the heap
+ *
+ * Can be overridden at compile time, but it has to be at least 1 and the same for the library and code using it.
+ */
+#ifndef BASICVECTOR_SMALL_CAPACITY
+#define BASICVECTOR_SMALL_CAPACITY 8
+#endif
+
+#if BASICVECTOR_SMALL_CAPACITY < 1
+#error "BASICVECTOR_SMALL_CAPACITY must be at least 1"
+#endif
 
 struct basicvector_s;
+struct basicvector_pool_s;
+struct basicvector_free_handle_s;
+struct basicvector_handles_s;
+struct basicvector_filter_s;
+struct basicvector_tombstones_s;
+struct basicvector_sharded_s;
+
+/*
+ * Per-vector operation counters, filled by basicvector_stats
+ *
+ * Counters are only maintained when the library is compiled with BASICVECTOR_STATS defined,
+ * otherwise no bookkeeping code is compiled in at all.
+ *
+ * Fields:
+ *  *_calls                 - Number of calls of given operation on the vector
+ *  *_entries_walked        - Total number of entries traversed, moved or filled by given operation (the O(n) part of its cost)
+ *  mallocs                 - Number of memory allocations made for the vector (including the vector structure itself, also when reused from the per-thread cache)
+ *  frees                   - Number of memory deallocations made for the vector, growing heap storage counts as both an allocation and a deallocation
+ *  peak_length             - Highest length the vector has ever reached
+ */
+struct basicvector_stats_s {
+    unsigned long long push_calls;
+    unsigned long long get_calls;
+    unsigned long long set_calls;
+    unsigned long long remove_calls;
+    unsigned long long find_calls;
+    unsigned long long find_index_calls;
+    unsigned long long length_calls;
+
+    unsigned long long push_entries_walked;
+    unsigned long long get_entries_walked;
+    unsigned long long set_entries_walked;
+    unsigned long long remove_entries_walked;
+    unsigned long long find_entries_walked;
+    unsigned long long find_index_entries_walked;
+
+    unsigned long long mallocs;
+    unsigned long long frees;
+
+    size_t peak_length;
+};
+
+/*
+ * Memory used by a vector, filled by basicvector_memory_usage and basicvector_memory_usage_total
+ *
+ * Heap allocations are measured with malloc_usable_size where available, so allocator rounding is included.
+ *
+ * Fields:
+ *  header_bytes    - Size of the vector structure, which holds inline storage of BASICVECTOR_SMALL_CAPACITY items
+ *  storage_bytes   - Size of heap or mapped storage of items, 0 while items fit into the vector structure
+ *  slack_bytes     - Part of storage_bytes not holding items, released by basicvector_compact
+ *  auxiliary_bytes - Size of handle tables, occupancy bitmap, membership filter and tombstone bitmap
+ *  total_bytes     - Sum of header_bytes, storage_bytes and auxiliary_bytes
+ *  item_count      - Number of items in the vector
+ *  vector_count    - Number of vectors covered by the report, 1 for basicvector_memory_usage
+ */
+struct basicvector_memory_usage_s {
+    size_t header_bytes;
+    size_t storage_bytes;
+    size_t slack_bytes;
+    size_t auxiliary_bytes;
+    size_t total_bytes;
+    size_t item_count;
+    size_t vector_count;
+};
+
+/*
+ * Bitmap of non-null items, one bit per item, built by the first basicvector_count_non_null or basicvector_next_non_null call
+ *
+ * Push, set and swap remove keep it up to date, other operations mark it invalid and it is rebuilt on next use.
+ */
+struct basicvector_occupancy_s {
+    uint64_t *words;
+    size_t word_capacity;
+    size_t non_null_count;
+    bool valid;
+};
+
+/*
+ * Vector structure layout
+ *
+ * Exposed so that vectors can be placed on the stack or inside other structures (see
+ * basicvector_init_inplace) and for the unchecked inline accessors (see BASICVECTOR_INLINE
+ * below), do not modify the fields directly. Items are stored contiguously in items[0..length),
+ * which points to small_items until more than BASICVECTOR_SMALL_CAPACITY items are stored.
+ *
+ * Warning:
+ *  Code using this structure must be compiled with the same BASICVECTOR_STATS and BASICVECTOR_SMALL_CAPACITY settings as the library.
+ */
+struct basicvector_s {
+    void **items;
+    size_t length;
+    size_t capacity;
+    // Whether heap storage of items was mapped with mmap rather than allocated with malloc
+    bool mapped;
+    void *small_items[BASICVECTOR_SMALL_CAPACITY];
+    // Slot table of generational handles, allocated by the first basicvector_insert_handle call
+    struct basicvector_handles_s *handles;
+    struct basicvector_occupancy_s occupancy;
+    // Membership filter, allocated by basicvector_filter_enable
+    struct basicvector_filter_s *filter;
+    // Slots of pending deferred removals, allocated by the first basicvector_remove_deferred call
+    struct basicvector_tombstones_s *tombstones;
+#ifdef BASICVECTOR_STATS
+    struct basicvector_stats_s stats;
+#endif
+};
 
 /*
  * Initialize vector structure
@@ -23,6 +156,60 @@ struct basicvector_s;
  */
 int basicvector_init(struct basicvector_s **vector);
 
+/*
+ * Initialize vector structure in memory provided by the caller (for ex. on the stack)
+ *
+ * Up to BASICVECTOR_SMALL_CAPACITY items are stored without any dynamic allocation.
+ *
+ * Params:
+ *  vector  - Pointer to uninitialized vector structure
+ *
+ * Warning:
+ *  The structure must not be copied or moved while in use, as it may point to its own storage. Release it with basicvector_free_inplace, not basicvector_free.
+ *
+ * Returns:
+ *  BASICVECTOR_MEMORY_ERROR    - Returned if vector is null
+ *  BASICVECTOR_SUCCESS         - If everything went ok
+ */
+int basicvector_init_inplace(struct basicvector_s *vector);
+
+/*
+ * Initialize vector structure holding a copy of count items
+ *
+ * Storage is allocated once with exactly count items and filled with a single copy, instead of growing it item by item.
+ *
+ * Params:
+ *  vector  - Pointer to pointer to vector structure
+ *  items   - Array of items to copy, may be null if count is 0
+ *  count   - Number of items in the array
+ *
+ * Returns:
+ *  BASICVECTOR_MEMORY_ERROR        - returned if vector is null or memory could not be allocated
+ *  BASICVECTOR_INVALID_ARGUMENT    - returned if items is null and count is not 0
+ *  BASICVECTOR_SUCCESS             - returned if everything went ok
+ */
+int basicvector_from_array(struct basicvector_s **vector, void **items, size_t count);
+
+/*
+ * Initialize vector structure taking over an array allocated with malloc as its storage, without copying items
+ *
+ * The vector owns the array afterwards and frees or reallocates it as its own storage. Arrays of any size are
+ * adopted as they are, including ones of 2 MB and more, which keep growing with realloc instead of moving into
+ * huge page storage.
+ *
+ * Params:
+ *  vector      - Pointer to pointer to vector structure
+ *  items       - Array allocated with malloc, calloc or realloc holding count items
+ *  count       - Number of items in the array
+ *  capacity    - Number of items the array has room for, at least count
+ *
+ * Returns:
+ *  BASICVECTOR_MEMORY_ERROR        - returned if vector is null or memory could not be allocated, the array stays owned by the caller
+ *  BASICVECTOR_INVALID_ARGUMENT    - returned if items is null or capacity is lower than count
+ *  BASICVECTOR_SUCCESS             - returned if everything went ok
+ */
+int basicvector_from_array_adopt(struct basicvector_s **vector, void **items, size_t count, size_t capacity);
+
 /*
  * Push item to vector structure
  *
@@ -32,6 +219,7 @@ int basicvector_init(struct basicvector_s **vector);
  *
  * Returns:
  *  BASICVECTOR_MEMORY_ERROR    - returned if error occured while tried to allocate memory dynamically (if malloc failed)
+ *  BASICVECTOR_UNSUPPORTED     - returned if the vector uses handles, see basicvector_insert_handle
  *  BASICVECTOR_SUCCESS         - returned if everything went ok
  */
 int basicvector_push(struct basicvector_s *vector, void *item);
@@ -51,6 +239,21 @@ int basicvector_push(struct basicvector_s *vector, void *item);
  */
 int basicvector_get(struct basicvector_s *vector, int index, void **result);
 
+/*
+ * Get item from basicvector structure, 64-bit index variant of basicvector_get
+ *
+ * Params:
+ *  vector  - Pointer to vector structure
+ *  index   - Index of item
+ *  result  - Pointer to variable that will receive the item
+ *
+ * Returns:
+ *  BASICVECTOR_MEMORY_ERROR    - returned if vector is NULL
+ *  BASICVECTOR_ITEM_NOT_FOUND  - returned if item with given index does not exist
+ *  BASICVECTOR_SUCCESS         - returned if everything went ok and value has been set to pointer under result argument
+ */
+int basicvector_get64(struct basicvector_s *vector, size_t index, void **result);
+
 /*
  * Find index of item in vector structure
  *
@@ -64,6 +267,7 @@ int basicvector_get(struct basicvector_s *vector, int index, void **result);
  *  BASICVECTOR_MEMORY_ERROR        - returned if passed vector is NULL
  *  BASICVECTOR_INVALID_ARGUMENT    - returned if passed search_function or result is NULL
  *  BASICVECTOR_ITEM_NOT_FOUND      - returned if search function returned false on every item or if vector is empty
+ *  BASICVECTOR_OVERFLOW            - returned if index of found item does not fit into int (see basicvector_find_index64)
  *  BASICVECTOR_SUCCESS             - returned if everything went ok
  */
 int basicvector_find_index(
@@ -73,6 +277,18 @@ int basicvector_find_index(
     void *user_data
 );
 
+/*
+ * Find index of item in vector structure, 64-bit index variant of basicvector_find_index
+ *
+ * Params and returned statuses are the same as in basicvector_find_index, except that result is a size_t and BASICVECTOR_OVERFLOW is never returned.
+ */
+int basicvector_find_index64(
+    struct basicvector_s *vector,
+    size_t *result,
+    bool (*search_function)(void *item, void *user_data),
+    void *user_data
+);
+
 /*
  * Find item in vector structure
  *
@@ -105,10 +321,59 @@ int basicvector_find(
  * Returns:
  *  BASICVECTOR_MEMORY_ERROR        - received when vector is null
  *  BASICVECTOR_INVALID_ARGUMENT    - received when passed result ptr is null
+ *  BASICVECTOR_OVERFLOW            - received when the count does not fit into int (see basicvector_length64)
  *  BASICVECTOR_SUCCESS             - received when everything went ok
  */
 int basicvector_length(struct basicvector_s *vector, int *result);
 
+/*
+ * Get count of total items inside the vector, 64-bit variant of basicvector_length
+ *
+ * Params:
+ *  vector  - Pointer to vector structure
+ *  result  - Pointer to size_t variable that will receive the count
+ *
+ * Returns:
+ *  BASICVECTOR_MEMORY_ERROR        - received when vector is null
+ *  BASICVECTOR_INVALID_ARGUMENT    - received when passed result ptr is null
+ *  BASICVECTOR_SUCCESS             - received when everything went ok
+ */
+int basicvector_length64(struct basicvector_s *vector, size_t *result);
+
+/*
+ * Copy all items of the vector into an array provided by the caller
+ *
+ * Params:
+ *  vector      - Pointer to vector structure
+ *  out         - Array receiving the items in order
+ *  capacity    - Number of items the array has room for
+ *
+ * Returns:
+ *  BASICVECTOR_MEMORY_ERROR        - returned if vector is null
+ *  BASICVECTOR_INVALID_ARGUMENT    - returned if out is null and the vector is not empty
+ *  BASICVECTOR_OVERFLOW            - returned if the items do not fit into capacity, nothing is copied then
+ *  BASICVECTOR_SUCCESS             - returned if everything went ok
+ */
+int basicvector_to_array(struct basicvector_s *vector, void **out, size_t capacity);
+
+/*
+ * Get pointer to the contiguous storage of the vector, holding its items at indices 0 to length - 1
+ *
+ * Params:
+ *  vector  - Pointer to vector structure
+ *  result  - Pointer to variable that will receive the storage pointer
+ *
+ * Warning:
+ *  The pointer is invalidated by any operation adding or removing items. Items may be read and replaced through it,
+ *  but replacing them bypasses the occupancy bitmap and membership filter, so avoid it when those are in use.
+ *
+ * Returns:
+ *  BASICVECTOR_MEMORY_ERROR        - returned if vector is null
+ *  BASICVECTOR_INVALID_ARGUMENT    - returned if result is null
+ *  BASICVECTOR_SUCCESS             - returned if everything went ok
+ */
+int basicvector_data(struct basicvector_s *vector, void ***result);
+
 /*
  * Sets item as given index inside the vector
  *
@@ -125,6 +390,7 @@ int basicvector_length(struct basicvector_s *vector, int *result);
  * Returns:
  *  BASICVECTOR_MEMORY_ERROR    - returned if vector is null or if error occured while allocating memory
  *  BASICVECTOR_INVALID_INDEX   - returned if passed index is below 0
+ *  BASICVECTOR_UNSUPPORTED     - returned if index is past the end of a vector using handles, see basicvector_insert_handle
  *  BASICVECTOR_SUCCESS         - returned if everything went ok 
  */
 int basicvector_set(
@@ -135,6 +401,19 @@ int basicvector_set(
     void *user_data
 );
 
+/*
+ * Sets item as given index inside the vector, 64-bit index variant of basicvector_set
+ *
+ * Params and returned statuses are the same as in basicvector_set, except that index is a size_t and BASICVECTOR_INVALID_INDEX is never returned.
+ */
+int basicvector_set64(
+    struct basicvector_s *vector,
+    size_t index,
+    void *item,
+    void (*deallocation_function)(void *item, void *user_data),
+    void *user_data
+);
+
 /*
  * Removes item of given index from the vector
  *
@@ -147,6 +426,7 @@ int basicvector_set(
  * Returns:
  *  BASICVECTOR_MEMORY_ERROR    - returned if vector is null
  *  BASICVECTOR_INVALID_INDEX   - returned if index does not exist inside the vector or if index is less than 0
+ *  BASICVECTOR_UNSUPPORTED     - returned if the vector uses handles, see basicvector_remove_handle
  *  BASICVECTOR_SUCCESS         - returned if everything went ok
  */
 int basicvector_remove(
@@ -157,17 +437,1053 @@ int basicvector_remove(
 );
 
 /*
- * Frees memory of vector structure and its items
+ * Removes item of given index from the vector, 64-bit index variant of basicvector_remove
+ *
+ * Params and returned statuses are the same as in basicvector_remove, except that index is a size_t.
+ */
+int basicvector_remove64(
+    struct basicvector_s *vector,
+    size_t index,
+    void (*deallocation_function)(void* item, void *user_data),
+    void *user_data
+);
+
+/*
+ * Overwrites count consecutive items starting at given index, growing the vector if needed
+ *
+ * Params:
+ *  vector          - Pointer to vector structure
+ *  index           - Index of the first item to set. Gaps between the end of the vector and index are filled with null items, like in basicvector_set.
+ *  items           - Array of count items to copy into the vector
+ *  count           - Number of items to set
+ *  dealloc_batch   - Function callback receiving non-null items that have been overwritten, all in one call (unless there are more than INT_MAX of them), and user_data. If passed null, the execution of the callback will be omitted.
+ *  user_data       - Context data for dealloc_batch
+ *
+ * Warning:
+ *  Items passed to dealloc_batch point into the vector storage, the vector must not be accessed from the callback.
+ *
+ * Returns:
+ *  BASICVECTOR_MEMORY_ERROR        - returned if vector is null or if there is a problem with allocating the memory
+ *  BASICVECTOR_INVALID_ARGUMENT    - returned if items is null and count is not 0
+ *  BASICVECTOR_UNSUPPORTED         - returned if the items reach past the end of a vector using handles, see basicvector_insert_handle
+ *  BASICVECTOR_SUCCESS             - returned if everything went ok
+ */
+int basicvector_set_batched(
+    struct basicvector_s *vector,
+    size_t index,
+    void **items,
+    size_t count,
+    void (*dealloc_batch)(void **items, int count, void *user_data),
+    void *user_data
+);
+
+/*
+ * Removes count consecutive items starting at given index, shifting the following items only once
+ *
+ * Params:
+ *  vector          - Pointer to vector structure
+ *  index           - Index of the first item to remove
+ *  count           - Number of items to remove
+ *  dealloc_batch   - Function callback receiving removed items, all in one call (unless there are more than INT_MAX of them), and user_data. If passed null, the execution of the callback will be omitted.
+ *  user_data       - Context data for dealloc_batch
+ *
+ * Warning:
+ *  Items passed to dealloc_batch point into the vector storage, the vector must not be accessed from the callback.
+ *
+ * Returns:
+ *  BASICVECTOR_MEMORY_ERROR    - returned if vector is null
+ *  BASICVECTOR_INVALID_INDEX   - returned if any of the items to remove is past the end of the vector
+ *  BASICVECTOR_UNSUPPORTED     - returned if the vector uses handles, see basicvector_remove_handle
+ *  BASICVECTOR_SUCCESS         - returned if everything went ok
+ */
+int basicvector_remove_batched(
+    struct basicvector_s *vector,
+    size_t index,
+    size_t count,
+    void (*dealloc_batch)(void **items, int count, void *user_data),
+    void *user_data
+);
+
+/*
+ * Removes item of given index in constant time by moving the last item of the vector into its place
  *
  * Params:
  *  vector                  - Pointer to vector structure
- *  deallocation_function   - Function callback used to deallocate items inside the vector. First argument is item to deallocate, second one is context data that you can pass by specyfing user_data arg (see user_data argument in basicvector_free function). If passed null as deallocation function, the execution of the callback will be omitted.
- *  user_data               - Context data for deallocation function (see deallocation_function arg in basicvector_free function)
+ *  index                   - Index of item to remove
+ *  deallocation_function   - Function callback used to deallocate the removed item, see basicvector_remove. If passed null, the execution of the callback will be omitted.
+ *  user_data               - Context data for deallocation function
+ *
+ * Warning:
+ *  Order of items is not preserved.
  *
  * Returns:
  *  BASICVECTOR_MEMORY_ERROR    - returned if vector is null
+ *  BASICVECTOR_INVALID_INDEX   - returned if index is not lower than vector length
+ *  BASICVECTOR_UNSUPPORTED     - returned if the vector uses handles, see basicvector_remove_handle
  *  BASICVECTOR_SUCCESS         - returned if everything went ok
  */
-int basicvector_free(struct basicvector_s *vector, void (*deallocation_function)(void *item, void *user_data), void *user_data);
+int basicvector_swap_remove(
+    struct basicvector_s *vector,
+    size_t index,
+    void (*deallocation_function)(void *item, void *user_data),
+    void *user_data
+);
+
+/*
+ * Removes all items matching predicate_function in a single pass, filling holes with items from the end of the vector
+ *
+ * Params:
+ *  vector                  - Pointer to vector structure
+ *  predicate_function      - Function returning true for items to remove. First argument is the item, second one is user_data.
+ *  deallocation_function   - Function callback used to deallocate removed items, see basicvector_remove. If passed null, the execution of the callback will be omitted.
+ *  user_data               - Context data for both predicate and deallocation function
+ *
+ * Warning:
+ *  Order of items is not preserved.
+ *
+ * Returns:
+ *  BASICVECTOR_MEMORY_ERROR        - returned if vector is null
+ *  BASICVECTOR_INVALID_ARGUMENT    - returned if predicate_function is null
+ *  BASICVECTOR_UNSUPPORTED         - returned if the vector uses handles, see basicvector_remove_handle
+ *  BASICVECTOR_SUCCESS             - returned if everything went ok
+ */
+int basicvector_swap_remove_if(
+    struct basicvector_s *vector,
+    bool (*predicate_function)(void *item, void *user_data),
+    void (*deallocation_function)(void *item, void *user_data),
+    void *user_data
+);
+
+/*
+ * Removes item of given index by marking its slot as a tombstone instead of shifting the items after it
+ *
+ * The item is deallocated right away and disappears from basicvector_get and basicvector_length, which keep using
+ * logical indices, so items after it move one index down just like with basicvector_remove. Tombstoned slots are
+ * dropped in a single pass once they make up more than the tombstone threshold of the storage (a quarter by default,
+ * see basicvector_set_tombstone_threshold), on basicvector_flush, or before any other operation on the vector.
+ * Removing many items with a get/remove_deferred loop therefore costs one pass over the vector instead of one per item.
+ *
+ * Params:
+ *  vector                  - Pointer to vector structure
+ *  index                   - Index of item to remove
+ *  deallocation_function   - Function callback used to deallocate the removed item, see basicvector_remove. If passed null, the execution of the callback will be omitted.
+ *  user_data               - Context data for deallocation function
+ *
+ * Warning:
+ *  basicvector_len_unchecked and basicvector_at_unchecked see tombstoned slots, call basicvector_flush before using them.
+ *
+ * Returns:
+ *  BASICVECTOR_MEMORY_ERROR    - returned if vector is null or the tombstone bitmap could not be allocated
+ *  BASICVECTOR_INVALID_INDEX   - returned if index is not lower than vector length
+ *  BASICVECTOR_UNSUPPORTED     - returned if the vector uses handles, see basicvector_remove_handle
+ *  BASICVECTOR_SUCCESS         - returned if everything went ok
+ */
+int basicvector_remove_deferred(
+    struct basicvector_s *vector,
+    size_t index,
+    void (*deallocation_function)(void *item, void *user_data),
+    void *user_data
+);
+
+/*
+ * Drops all slots tombstoned by basicvector_remove_deferred, keeping order of the remaining items
+ *
+ * Params:
+ *  vector  - Pointer to vector structure
+ *
+ * Returns:
+ *  BASICVECTOR_MEMORY_ERROR    - returned if vector is null
+ *  BASICVECTOR_SUCCESS         - returned if everything went ok, also when there was nothing to drop
+ */
+int basicvector_flush(struct basicvector_s *vector);
+
+/*
+ * Sets fraction of tombstoned slots above which basicvector_remove_deferred drops them automatically
+ *
+ * Params:
+ *  vector      - Pointer to vector structure
+ *  threshold   - Fraction of the slots in (0, 1], 1 leaves dropping to basicvector_flush and other operations
+ *
+ * Returns:
+ *  BASICVECTOR_MEMORY_ERROR        - returned if vector is null or the tombstone state could not be allocated
+ *  BASICVECTOR_INVALID_ARGUMENT    - returned if threshold is out of range
+ *  BASICVECTOR_SUCCESS             - returned if everything went ok
+ */
+int basicvector_set_tombstone_threshold(struct basicvector_s *vector, double threshold);
+
+/*
+ * Reorders items of the vector into a heap in O(n), so that the item ordered first by compare_function is at index 0
+ *
+ * Heap functions keep items in the vector storage as an implicit d-ary tree, children of item i are at indexes
+ * arity * i + 1 to arity * i + arity. BASICVECTOR_HEAP_BINARY is the classic binary heap, BASICVECTOR_HEAP_QUATERNARY
+ * makes the tree shallower and keeps children of a node within a cache line, which usually makes pops faster
+ * on large heaps. All heap functions used on a vector must be given the same arity and compare_function.
+ *
+ * Params:
+ *  vector              - Pointer to vector structure
+ *  arity               - Number of children of every node, at least 2
+ *  compare_function    - Function returning negative value if left item should be popped before right one, positive if after and 0 if they are equal
+ *  user_data           - Context data passed to compare_function
+ *
+ * Returns:
+ *  BASICVECTOR_MEMORY_ERROR        - returned if vector is null
+ *  BASICVECTOR_INVALID_ARGUMENT    - returned if arity is lower than 2 or compare_function is null
+ *  BASICVECTOR_UNSUPPORTED         - returned if the vector uses handles, see basicvector_remove_handle
+ *  BASICVECTOR_SUCCESS             - returned if everything went ok
+ */
+int basicvector_heapify(
+    struct basicvector_s *vector,
+    int arity,
+    int (*compare_function)(void *left, void *right, void *user_data),
+    void *user_data
+);
+
+/*
+ * Pushes item into the heap kept in the vector in O(log n)
+ *
+ * Params:
+ *  vector              - Pointer to vector structure holding a heap, see basicvector_heapify
+ *  item                - Item to push
+ *  arity               - Number of children of every node, see basicvector_heapify
+ *  compare_function    - Function ordering items, see basicvector_heapify
+ *  user_data           - Context data passed to compare_function
+ *
+ * Returns:
+ *  BASICVECTOR_MEMORY_ERROR        - returned if vector is null or if there is a problem with allocating the memory
+ *  BASICVECTOR_INVALID_ARGUMENT    - returned if arity is lower than 2 or compare_function is null
+ *  BASICVECTOR_UNSUPPORTED         - returned if the vector uses handles, see basicvector_remove_handle
+ *  BASICVECTOR_SUCCESS             - returned if everything went ok
+ */
+int basicvector_heap_push(
+    struct basicvector_s *vector,
+    void *item,
+    int arity,
+    int (*compare_function)(void *left, void *right, void *user_data),
+    void *user_data
+);
+
+/*
+ * Removes the first item of the heap kept in the vector in O(log n)
+ *
+ * Params:
+ *  vector              - Pointer to vector structure holding a heap, see basicvector_heapify
+ *  result              - Pointer to variable that will receive the removed item
+ *  arity               - Number of children of every node, see basicvector_heapify
+ *  compare_function    - Function ordering items, see basicvector_heapify
+ *  user_data           - Context data passed to compare_function
+ *
+ * Returns:
+ *  BASICVECTOR_MEMORY_ERROR        - returned if vector is null
+ *  BASICVECTOR_INVALID_ARGUMENT    - returned if result is null, arity is lower than 2 or compare_function is null
+ *  BASICVECTOR_UNSUPPORTED         - returned if the vector uses handles, see basicvector_remove_handle
+ *  BASICVECTOR_ITEM_NOT_FOUND      - returned if the heap is empty
+ *  BASICVECTOR_SUCCESS             - returned if everything went ok
+ */
+int basicvector_heap_pop(
+    struct basicvector_s *vector,
+    void **result,
+    int arity,
+    int (*compare_function)(void *left, void *right, void *user_data),
+    void *user_data
+);
+
+/*
+ * Get the first item of the heap kept in the vector without removing it
+ *
+ * Params:
+ *  vector  - Pointer to vector structure holding a heap, see basicvector_heapify
+ *  result  - Pointer to variable that will receive the item
+ *
+ * Returns:
+ *  BASICVECTOR_MEMORY_ERROR        - returned if vector is null
+ *  BASICVECTOR_INVALID_ARGUMENT    - returned if result is null
+ *  BASICVECTOR_ITEM_NOT_FOUND      - returned if the heap is empty
+ *  BASICVECTOR_SUCCESS             - returned if everything went ok
+ */
+int basicvector_heap_peek(struct basicvector_s *vector, void **result);
+
+/*
+ * Moves all items of source vector to the end of destination vector
+ *
+ * If destination is empty, it takes over the heap storage of source without copying. Otherwise items are copied with a single memcpy.
+ *
+ * Params:
+ *  destination - Pointer to vector structure receiving the items
+ *  source      - Pointer to vector structure the items are moved from. It is left empty and can still be used or freed.
+ *
+ * Returns:
+ *  BASICVECTOR_MEMORY_ERROR        - returned if destination or source is null or if there is a problem with allocating the memory, in which case both vectors are left unchanged
+ *  BASICVECTOR_INVALID_ARGUMENT    - returned if destination and source are the same vector
+ *  BASICVECTOR_SUCCESS             - returned if everything went ok
+ */
+int basicvector_append_vector(struct basicvector_s *destination, struct basicvector_s *source);
+
+/*
+ * Moves all items of source vector into destination vector, inserting them before item of given index
+ *
+ * Params:
+ *  destination - Pointer to vector structure receiving the items
+ *  index       - Index the first moved item will have in destination, equal to destination length appends the items
+ *  source      - Pointer to vector structure the items are moved from. It is left empty and can still be used or freed.
+ *
+ * Returns:
+ *  BASICVECTOR_MEMORY_ERROR        - returned if destination or source is null or if there is a problem with allocating the memory, in which case both vectors are left unchanged
+ *  BASICVECTOR_INVALID_ARGUMENT    - returned if destination and source are the same vector
+ *  BASICVECTOR_INVALID_INDEX       - returned if index is greater than destination length
+ *  BASICVECTOR_SUCCESS             - returned if everything went ok
+ */
+int basicvector_splice(struct basicvector_s *destination, size_t index, struct basicvector_s *source);
+
+/*
+ * Detaches items from given index onward into a new vector
+ *
+ * Splitting at 0 moves the heap storage to the tail without copying. Otherwise the tail items are copied with a single memcpy and the vector keeps its storage.
+ *
+ * Params:
+ *  vector  - Pointer to vector structure, it keeps items before index
+ *  index   - Index of the first item moved to the tail, equal to vector length creates an empty tail
+ *  tail    - Pointer to pointer that will receive the new vector. Free it with basicvector_free.
+ *
+ * Returns:
+ *  BASICVECTOR_MEMORY_ERROR        - returned if vector is null or if memory for the tail could not be allocated, in which case the vector is left unchanged
+ *  BASICVECTOR_INVALID_ARGUMENT    - returned if tail is null
+ *  BASICVECTOR_INVALID_INDEX       - returned if index is greater than vector length
+ *  BASICVECTOR_SUCCESS             - returned if everything went ok
+ */
+int basicvector_split(struct basicvector_s *vector, size_t index, struct basicvector_s **tail);
+
+/*
+ * Drops items from the end of the vector so that it has new_length items
+ *
+ * Params:
+ *  vector                  - Pointer to vector structure
+ *  new_length              - Number of items to keep
+ *  deallocation_function   - Function callback used to deallocate dropped items, see basicvector_free. If passed null, the execution of the callback will be omitted.
+ *  user_data               - Context data for deallocation function
+ *
+ * Returns:
+ *  BASICVECTOR_MEMORY_ERROR    - returned if vector is null
+ *  BASICVECTOR_INVALID_INDEX   - returned if new_length is greater than vector length
+ *  BASICVECTOR_UNSUPPORTED     - returned if the vector uses handles, see basicvector_remove_handle
+ *  BASICVECTOR_SUCCESS         - returned if everything went ok
+ */
+int basicvector_truncate(
+    struct basicvector_s *vector,
+    size_t new_length,
+    void (*deallocation_function)(void *item, void *user_data),
+    void *user_data
+);
+
+/*
+ * Shrinks storage of the vector to fit its items, moving them back inside the vector structure if they fit into its inline storage
+ *
+ * Items are always stored contiguously, so there is nothing to defragment. Compacting releases the slack left after the
+ * vector has shrunk, so that scans touch fewer pages and the memory can be reused. Building with BASICVECTOR_AUTO_COMPACT
+ * compacts automatically whenever removals leave less than a quarter of the storage in use.
+ *
+ * Params:
+ *  vector  - Pointer to vector structure
+ *
+ * Warning:
+ *  Pointers returned by basicvector_at_unchecked or taken from the storage are invalidated.
+ *
+ * Returns:
+ *  BASICVECTOR_MEMORY_ERROR    - returned if vector is null
+ *  BASICVECTOR_SUCCESS         - returned if everything went ok, also when the storage could not be shrunk
+ */
+int basicvector_compact(struct basicvector_s *vector);
+
+/*
+ * Advises the kernel about the expected access pattern of the vector storage
+ *
+ * Storage of 2 MB and above is mapped at huge page alignment and marked for transparent huge pages, advice applies to it
+ * as well as to smaller heap storage. Inline storage of small vectors is left alone.
+ *
+ * Params:
+ *  vector  - Pointer to vector structure
+ *  advice  - One of:
+ *      BASICVECTOR_ADVICE_NORMAL       - no special treatment
+ *      BASICVECTOR_ADVICE_SEQUENTIAL   - items will be accessed in order, read ahead aggressively
+ *      BASICVECTOR_ADVICE_RANDOM       - items will be accessed in random order, do not read ahead
+ *      BASICVECTOR_ADVICE_WILLNEED     - items will be accessed soon, fault them in ahead of time
+ *      BASICVECTOR_ADVICE_DONTNEED     - release unused capacity past the last item to the kernel, items are kept
+ *
+ * Returns:
+ *  BASICVECTOR_MEMORY_ERROR        - returned if vector is null
+ *  BASICVECTOR_INVALID_ARGUMENT    - returned if advice is not one of the above
+ *  BASICVECTOR_UNSUPPORTED         - returned if the platform or the kernel does not support the advice
+ *  BASICVECTOR_SUCCESS             - returned if everything went ok
+ */
+int basicvector_advise(struct basicvector_s *vector, int advice);
+
+/*
+ * Pushes item at the end of the vector and returns a stable handle to it
+ *
+ * Handles stay valid until their item is removed with basicvector_remove_handle, no matter how other items move. Items stay
+ * densely packed in the vector, so they can still be iterated with basicvector_get or basicvector_for_each, but their order
+ * changes as items are removed.
+ *
+ * Params:
+ *  vector  - Pointer to vector structure
+ *  item    - Item to push
+ *  handle  - Pointer to variable that will receive the handle, made of a slot index and a generation detecting reuse of the slot
+ *
+ * Warning:
+ *  Once handles are used, items must be added and removed only with basicvector_insert_handle and basicvector_remove_handle.
+ *  Other functions adding, removing or reordering items return BASICVECTOR_UNSUPPORTED for such a vector.
+ *  Items present before the first handle was created get slots as well, but no handles are returned for them.
+ *
+ * Returns:
+ *  BASICVECTOR_MEMORY_ERROR        - returned if vector is null or if there is a problem with allocating the memory
+ *  BASICVECTOR_INVALID_ARGUMENT    - returned if handle is null
+ *  BASICVECTOR_UNSUPPORTED         - returned if items have been added or removed without handle functions, or the vector has 2^32 - 1 items
+ *  BASICVECTOR_SUCCESS             - returned if everything went ok
+ */
+int basicvector_insert_handle(struct basicvector_s *vector, void *item, uint64_t *handle);
+
+/*
+ * Get item referenced by handle in constant time
+ *
+ * Params:
+ *  vector  - Pointer to vector structure
+ *  handle  - Handle returned by basicvector_insert_handle
+ *  result  - Pointer to variable that will receive the item
+ *
+ * Returns:
+ *  BASICVECTOR_MEMORY_ERROR        - returned if vector is null
+ *  BASICVECTOR_INVALID_ARGUMENT    - returned if result is null
+ *  BASICVECTOR_ITEM_NOT_FOUND      - returned if the handle is stale, because its item has been removed, or it has never been issued by the vector
+ *  BASICVECTOR_SUCCESS             - returned if everything went ok
+ */
+int basicvector_get_handle(struct basicvector_s *vector, uint64_t handle, void **result);
+
+/*
+ * Removes item referenced by handle in constant time, moving the last item of the vector into its place
+ *
+ * Params:
+ *  vector                  - Pointer to vector structure
+ *  handle                  - Handle returned by basicvector_insert_handle, it becomes stale
+ *  deallocation_function   - Function callback used to deallocate the removed item, see basicvector_remove. If passed null, the execution of the callback will be omitted.
+ *  user_data               - Context data for deallocation function
+ *
+ * Returns:
+ *  BASICVECTOR_MEMORY_ERROR        - returned if vector is null
+ *  BASICVECTOR_ITEM_NOT_FOUND      - returned if the handle is stale or has never been issued by the vector
+ *  BASICVECTOR_UNSUPPORTED         - returned if items have been added or removed without handle functions
+ *  BASICVECTOR_SUCCESS             - returned if everything went ok
+ */
+int basicvector_remove_handle(
+    struct basicvector_s *vector,
+    uint64_t handle,
+    void (*deallocation_function)(void *item, void *user_data),
+    void *user_data
+);
+
+/*
+ * Counts items of the vector that are not null
+ *
+ * The count is kept in the occupancy bitmap, so it takes constant time unless the bitmap has to be rebuilt after
+ * operations that move items, which takes one pass over the vector.
+ *
+ * Params:
+ *  vector  - Pointer to vector structure
+ *  result  - Pointer to variable that will receive the number of non-null items
+ *
+ * Returns:
+ *  BASICVECTOR_MEMORY_ERROR        - returned if vector is null or if memory for the occupancy bitmap could not be allocated
+ *  BASICVECTOR_INVALID_ARGUMENT    - returned if result is null
+ *  BASICVECTOR_SUCCESS             - returned if everything went ok
+ */
+int basicvector_count_non_null(struct basicvector_s *vector, size_t *result);
+
+/*
+ * Finds the first non-null item at or after given index, skipping null items 64 at a time using the occupancy bitmap
+ *
+ * Iterating over non-null items:
+ *  for (size_t i = 0; basicvector_next_non_null(vector, i, &i) == BASICVECTOR_SUCCESS; i++) { ... }
+ *
+ * Params:
+ *  vector  - Pointer to vector structure
+ *  from    - Index to start searching at
+ *  index   - Pointer to variable that will receive index of the found item
+ *
+ * Returns:
+ *  BASICVECTOR_MEMORY_ERROR        - returned if vector is null or if memory for the occupancy bitmap could not be allocated
+ *  BASICVECTOR_INVALID_ARGUMENT    - returned if index is null
+ *  BASICVECTOR_ITEM_NOT_FOUND      - returned if there are only null items at and after from
+ *  BASICVECTOR_SUCCESS             - returned if everything went ok
+ */
+int basicvector_next_non_null(struct basicvector_s *vector, size_t from, size_t *index);
+
+/*
+ * Enables bloom filter of item hashes, letting basicvector_find_by_hash return without scanning when an item is definitely absent
+ *
+ * Pushed and set items are added to the filter as they arrive. Removed items cannot be taken out of it, so once the
+ * filter holds twice as many hashes as the vector has items, or after operations moving many items into the vector
+ * at once, it is rebuilt by the next basicvector_find_by_hash call.
+ *
+ * Null items, including the gaps basicvector_set fills past the end of the vector, are never passed to
+ * hash_function, so it may dereference items. They are not added to the filter either and cannot be found
+ * with basicvector_find_by_hash while it is enabled.
+ *
+ * Params:
+ *  vector          - Pointer to vector structure
+ *  hash_function   - Function returning 64-bit hash of an item, equal items must have equal hashes
+ *  user_data       - Context data passed to hash_function
+ *
+ * Returns:
+ *  BASICVECTOR_MEMORY_ERROR        - returned if vector is null or if memory for the filter could not be allocated
+ *  BASICVECTOR_INVALID_ARGUMENT    - returned if hash_function is null
+ *  BASICVECTOR_SUCCESS             - returned if everything went ok
+ */
+int basicvector_filter_enable(
+    struct basicvector_s *vector,
+    uint64_t (*hash_function)(void *item, void *user_data),
+    void *user_data
+);
+
+/*
+ * Disables and frees the bloom filter of the vector
+ *
+ * Params:
+ *  vector  - Pointer to vector structure
+ *
+ * Returns:
+ *  BASICVECTOR_MEMORY_ERROR    - returned if vector is null
+ *  BASICVECTOR_SUCCESS         - returned if everything went ok, also when the filter was not enabled
+ */
+int basicvector_filter_disable(struct basicvector_s *vector);
+
+/*
+ * Finds first item matching search_function, skipping the scan when the bloom filter rules out an item with given hash
+ *
+ * Params:
+ *  vector          - Pointer to vector structure
+ *  result          - Pointer to variable that will receive found item, or null if nothing has been found
+ *  hash            - Hash of the searched item, computed the same way as by hash_function passed to basicvector_filter_enable
+ *  search_function - Function returning true for the searched item, see basicvector_find. It must only match items with given hash.
+ *  user_data       - Context data passed to search_function
+ *
+ * Without an enabled filter this is the same as basicvector_find.
+ *
+ * Returns:
+ *  BASICVECTOR_MEMORY_ERROR        - returned if vector is null
+ *  BASICVECTOR_INVALID_ARGUMENT    - returned if result or search_function is null
+ *  BASICVECTOR_ITEM_NOT_FOUND      - returned if no item matches
+ *  BASICVECTOR_SUCCESS             - returned if everything went ok
+ */
+int basicvector_find_by_hash(
+    struct basicvector_s *vector,
+    void **result,
+    uint64_t hash,
+    bool (*search_function)(void *item, void *user_data),
+    void *user_data
+);
+
+/*
+ * Frees memory of vector structure and its items
+ *
+ * Params:
+ *  vector                  - Pointer to vector structure
+ *  deallocation_function   - Function callback used to deallocate items inside the vector. First argument is item to deallocate, second one is context data that you can pass by specyfing user_data arg (see user_data argument in basicvector_free function). If passed null as deallocation function, the execution of the callback will be omitted.
+ *  user_data               - Context data for deallocation function (see deallocation_function arg in basicvector_free function)
+ *
+ * Returns:
+ *  BASICVECTOR_MEMORY_ERROR    - returned if vector is null
+ *  BASICVECTOR_SUCCESS         - returned if everything went ok
+ */
+int basicvector_free(struct basicvector_s *vector, void (*deallocation_function)(void *item, void *user_data), void *user_data);
+
+/*
+ * Frees memory of vector structure and its items, passing items to the deallocation callback in batches
+ *
+ * Params:
+ *  vector          - Pointer to vector structure
+ *  dealloc_batch   - Function callback used to deallocate items. It receives pointer to count consecutive items (the whole vector unless it holds more than INT_MAX items) and user_data. If passed null, the execution of the callback will be omitted.
+ *  user_data       - Context data for dealloc_batch
+ *
+ * Returns:
+ *  BASICVECTOR_MEMORY_ERROR    - returned if vector is null
+ *  BASICVECTOR_SUCCESS         - returned if everything went ok
+ */
+int basicvector_free_batched(struct basicvector_s *vector, void (*dealloc_batch)(void **items, int count, void *user_data), void *user_data);
+
+/*
+ * Frees memory of vector structure and its items, calling deallocation function on items in parallel on the library thread pool
+ *
+ * Params:
+ *  vector                  - Pointer to vector structure
+ *  deallocation_function   - Function callback used to deallocate items, see basicvector_free. It is called concurrently from several threads and in no particular order. If passed null, the execution of the callback will be omitted.
+ *  user_data               - Context data for deallocation function
+ *
+ * Returns:
+ *  BASICVECTOR_MEMORY_ERROR    - returned if vector is null
+ *  BASICVECTOR_SUCCESS         - returned if everything went ok
+ */
+int basicvector_free_parallel(
+    struct basicvector_s *vector,
+    void (*deallocation_function)(void *item, void *user_data),
+    void *user_data
+);
+
+/*
+ * Starts incremental destruction of the vector, items are deallocated by subsequent basicvector_free_step calls
+ *
+ * Params:
+ *  vector                  - Pointer to vector structure created with basicvector_init. It belongs to the handle from now on and must not be used anymore.
+ *  handle                  - Pointer to pointer that will receive the handle passed to basicvector_free_step
+ *  deallocation_function   - Function callback used to deallocate items, see basicvector_free. If passed null, the execution of the callback will be omitted.
+ *  user_data               - Context data for deallocation function
+ *
+ * Returns:
+ *  BASICVECTOR_MEMORY_ERROR        - returned if vector is null or if memory for the handle could not be allocated
+ *  BASICVECTOR_INVALID_ARGUMENT    - returned if handle is null
+ *  BASICVECTOR_SUCCESS             - returned if everything went ok
+ */
+int basicvector_free_begin(
+    struct basicvector_s *vector,
+    struct basicvector_free_handle_s **handle,
+    void (*deallocation_function)(void *item, void *user_data),
+    void *user_data
+);
+
+/*
+ * Deallocates at most budget_items next items of the vector being destroyed, bounding the time spent in a single call
+ *
+ * Params:
+ *  handle          - Pointer to handle created by basicvector_free_begin
+ *  budget_items    - Maximum number of items to deallocate in this call
+ *  remaining       - Pointer to variable that will receive the number of items still to deallocate. When it is 0, the vector storage and the handle have been freed and the handle must not be used anymore.
+ *
+ * Returns:
+ *  BASICVECTOR_MEMORY_ERROR        - returned if handle is null
+ *  BASICVECTOR_INVALID_ARGUMENT    - returned if remaining is null
+ *  BASICVECTOR_SUCCESS             - returned if everything went ok
+ */
+int basicvector_free_step(struct basicvector_free_handle_s *handle, size_t budget_items, size_t *remaining);
+
+/*
+ * Hands the vector over to a background reclaimer thread, which frees it and its items off the calling thread
+ *
+ * The reclaimer thread is started on first use and frees queued vectors in order.
+ *
+ * Params:
+ *  vector                  - Pointer to vector structure created with basicvector_init. It belongs to the reclaimer from now on and must not be used anymore.
+ *  deallocation_function   - Function callback used to deallocate items, see basicvector_free. It is called from the reclaimer thread. If passed null, the execution of the callback will be omitted.
+ *  user_data               - Context data for deallocation function
+ *
+ * Returns:
+ *  BASICVECTOR_MEMORY_ERROR    - returned if vector is null or if the vector could not be queued, in which case it is still owned by the caller
+ *  BASICVECTOR_SUCCESS         - returned if everything went ok
+ */
+int basicvector_free_background(
+    struct basicvector_s *vector,
+    void (*deallocation_function)(void *item, void *user_data),
+    void *user_data
+);
+
+/*
+ * Waits until the background reclaimer has freed every vector queued so far
+ *
+ * Returns:
+ *  BASICVECTOR_SUCCESS     - returned if everything went ok
+ */
+int basicvector_free_background_wait(void);
+
+/*
+ * Frees memory of items storage of vector initialized with basicvector_init_inplace and its items, without freeing the vector structure itself
+ *
+ * Params:
+ *  vector                  - Pointer to vector structure
+ *  deallocation_function   - Function callback used to deallocate items inside the vector, see basicvector_free. If passed null as deallocation function, the execution of the callback will be omitted.
+ *  user_data               - Context data for deallocation function
+ *
+ * Returns:
+ *  BASICVECTOR_MEMORY_ERROR    - returned if vector is null
+ *  BASICVECTOR_SUCCESS         - returned if everything went ok
+ */
+int basicvector_free_inplace(struct basicvector_s *vector, void (*deallocation_function)(void *item, void *user_data), void *user_data);
+
+/*
+ * Calls function on every item of the vector, in order, on the calling thread
+ *
+ * Params:
+ *  vector      - Pointer to vector structure
+ *  function    - Function called with every item and user_data
+ *  user_data   - Context data passed to function
+ *
+ * Returns:
+ *  BASICVECTOR_MEMORY_ERROR        - returned if vector is null
+ *  BASICVECTOR_INVALID_ARGUMENT    - returned if function is null
+ *  BASICVECTOR_SUCCESS             - returned if everything went ok
+ */
+int basicvector_for_each(
+    struct basicvector_s *vector,
+    void (*function)(void *item, void *user_data),
+    void *user_data
+);
+
+/*
+ * Calls function on every item of the vector, spreading chunks of items across the library thread pool
+ *
+ * Params:
+ *  vector      - Pointer to vector structure
+ *  function    - Function called with every item and user_data. It is called concurrently from several threads and in no particular order.
+ *  user_data   - Context data passed to function
+ *
+ * Warning:
+ *  The vector must not be modified until this function returns.
+ *
+ * Returns:
+ *  BASICVECTOR_MEMORY_ERROR        - returned if vector is null
+ *  BASICVECTOR_INVALID_ARGUMENT    - returned if function is null
+ *  BASICVECTOR_SUCCESS             - returned if everything went ok
+ */
+int basicvector_parallel_for_each(
+    struct basicvector_s *vector,
+    void (*function)(void *item, void *user_data),
+    void *user_data
+);
+
+/*
+ * Creates new vector with items transformed by map_function, computed in parallel on the library thread pool
+ *
+ * Params:
+ *  vector          - Pointer to vector structure
+ *  result          - Pointer to pointer that will receive the new vector, item under index i is the result of map_function called on item under index i. Free it with basicvector_free.
+ *  map_function    - Function returning transformed item. It is called concurrently from several threads and in no particular order.
+ *  user_data       - Context data passed to map_function
+ *
+ * Returns:
+ *  BASICVECTOR_MEMORY_ERROR        - returned if vector is null or if memory for the new vector could not be allocated
+ *  BASICVECTOR_INVALID_ARGUMENT    - returned if result or map_function is null
+ *  BASICVECTOR_SUCCESS             - returned if everything went ok
+ */
+int basicvector_map_into(
+    struct basicvector_s *vector,
+    struct basicvector_s **result,
+    void *(*map_function)(void *item, void *user_data),
+    void *user_data
+);
+
+/*
+ * Reduces items of the vector to single value, computed in parallel on the library thread pool
+ *
+ * Items are split into chunks. Each chunk is folded with reduce_function starting from initial_value, and the partial
+ * results of the chunks are then merged in order with combine_function. The accumulator does not have to be of the item
+ * type, so items can for example be counted or summed into a wider value.
+ *
+ * Params:
+ *  vector              - Pointer to vector structure
+ *  result              - Pointer to variable that will receive reduced value
+ *  initial_value       - Value every chunk starts with and the result for empty vector. It has to be an identity of combine_function, as it is folded in once per chunk.
+ *  reduce_function     - Function folding one item into an accumulator. It is called concurrently from several threads.
+ *  combine_function    - Function merging two partial results into one, called in item order. It has to be associative, as where the items are split into chunks is not specified.
+ *  user_data           - Context data passed to reduce_function and combine_function
+ *
+ * Returns:
+ *  BASICVECTOR_MEMORY_ERROR        - returned if vector is null or if memory for partial results could not be allocated
+ *  BASICVECTOR_INVALID_ARGUMENT    - returned if result, reduce_function or combine_function is null
+ *  BASICVECTOR_SUCCESS             - returned if everything went ok
+ */
+int basicvector_reduce_parallel(
+    struct basicvector_s *vector,
+    void **result,
+    void *initial_value,
+    void *(*reduce_function)(void *accumulator, void *item, void *user_data),
+    void *(*combine_function)(void *left, void *right, void *user_data),
+    void *user_data
+);
+
+/*
+ * Finds the lowest index of item matching search_function, searching in parallel on the library thread pool
+ *
+ * Params:
+ *  vector          - Pointer to vector structure
+ *  result          - Pointer to variable that will receive index of the first matching item
+ *  search_function - Function returning true for matching items. It is called concurrently from several threads and may be called for items after the first match.
+ *  user_data       - Context data passed to search_function
+ *
+ * Returns:
+ *  BASICVECTOR_MEMORY_ERROR        - returned if vector is null
+ *  BASICVECTOR_INVALID_ARGUMENT    - returned if result or search_function is null
+ *  BASICVECTOR_ITEM_NOT_FOUND      - returned if no item matches
+ *  BASICVECTOR_SUCCESS             - returned if everything went ok
+ */
+int basicvector_parallel_find_index(
+    struct basicvector_s *vector,
+    size_t *result,
+    bool (*search_function)(void *item, void *user_data),
+    void *user_data
+);
+
+/*
+ * Sorts items of the vector with stable merge sort, runs and merges of short runs are spread across the library thread pool
+ *
+ * Params:
+ *  vector              - Pointer to vector structure
+ *  compare_function    - Function returning negative value if left item goes before right one, positive if after and 0 if they are equal. It is called concurrently from several threads.
+ *  user_data           - Context data passed to compare_function
+ *
+ * Warning:
+ *  The last merge passes process few long runs and use fewer threads, so the speedup is lower than for basicvector_parallel_for_each.
+ *
+ * Returns:
+ *  BASICVECTOR_MEMORY_ERROR        - returned if vector is null or if memory for the merge buffer could not be allocated
+ *  BASICVECTOR_INVALID_ARGUMENT    - returned if compare_function is null
+ *  BASICVECTOR_UNSUPPORTED         - returned if the vector uses handles, whose items must keep their positions
+ *  BASICVECTOR_SUCCESS             - returned if everything went ok
+ */
+int basicvector_sort(
+    struct basicvector_s *vector,
+    int (*compare_function)(void *left, void *right, void *user_data),
+    void *user_data
+);
+
+/*
+ * Creates work-stealing thread pool that can run parallel vector operations
+ *
+ * Every worker owns a deque of item ranges. Ranges are split in halves lazily, and idle workers steal the
+ * halves of busy ones, so work stays balanced even when the cost of items is very uneven. The thread calling
+ * a parallel operation works on it as well.
+ *
+ * A pool runs one operation at a time. An operation started while the pool is busy with another caller's one,
+ * or from inside a callback of a running operation, runs on the calling thread alone instead of waiting.
+ *
+ * Params:
+ *  pool            - Pointer to pointer that will receive the new pool
+ *  thread_count    - Number of worker threads. Negative value creates one worker per online CPU except one, 0 creates a pool running everything on the calling thread.
+ *
+ * Returns:
+ *  BASICVECTOR_MEMORY_ERROR        - returned if memory for the pool could not be allocated
+ *  BASICVECTOR_INVALID_ARGUMENT    - returned if pool is null
+ *  BASICVECTOR_SUCCESS             - returned if everything went ok, the pool may have fewer workers if some threads could not be started
+ */
+int basicvector_pool_create(struct basicvector_pool_s **pool, int thread_count);
+
+/*
+ * Stops worker threads of the pool and frees it
+ *
+ * If the pool is the default one, the built-in pool becomes the default again. Operations already running on
+ * the pool, including ones started by other threads, are waited for before it is freed.
+ *
+ * Params:
+ *  pool    - Pointer to pool structure
+ *
+ * Warning:
+ *  Must not be called from a callback of a parallel operation, which would wait for itself.
+ *
+ * Returns:
+ *  BASICVECTOR_MEMORY_ERROR    - returned if pool is null
+ *  BASICVECTOR_SUCCESS         - returned if everything went ok
+ */
+int basicvector_pool_free(struct basicvector_pool_s *pool);
+
+/*
+ * Sets the pool used by all parallel vector operations
+ *
+ * Params:
+ *  pool    - Pointer to pool structure, null restores the built-in pool, created on first use with one worker per online CPU except one
+ *
+ * Returns:
+ *  BASICVECTOR_SUCCESS     - returned if everything went ok
+ */
+int basicvector_pool_set_default(struct basicvector_pool_s *pool);
+
+/*
+ * Get number of worker threads of the pool, not counting the thread calling parallel operations
+ *
+ * Params:
+ *  pool    - Pointer to pool structure
+ *  result  - Pointer to variable that will receive the number of workers
+ *
+ * Returns:
+ *  BASICVECTOR_MEMORY_ERROR        - returned if pool is null
+ *  BASICVECTOR_INVALID_ARGUMENT    - returned if result is null
+ *  BASICVECTOR_SUCCESS             - returned if everything went ok
+ */
+int basicvector_pool_thread_count(struct basicvector_pool_s *pool, int *result);
+
+/*
+ * Initialize sharded vector, which spreads pushes from many threads over shards with a lock each
+ *
+ * Each thread pushes into the shard picked by its thread number, so threads only contend when there are
+ * more of them than shards. Items pushed by one thread keep their order, items of different threads do not.
+ * The sharded vector is meant to be filled concurrently and read or collected once writers are done.
+ *
+ * Params:
+ *  sharded     - Pointer to pointer that will receive the new sharded vector
+ *  shard_count - Number of shards, 0 or less creates one shard per online CPU
+ *
+ * Returns:
+ *  BASICVECTOR_MEMORY_ERROR        - returned if memory for the shards could not be allocated
+ *  BASICVECTOR_INVALID_ARGUMENT    - returned if sharded is null
+ *  BASICVECTOR_SUCCESS             - returned if everything went ok
+ */
+int basicvector_sharded_init(struct basicvector_sharded_s **sharded, int shard_count);
+
+/*
+ * Push item into the shard of the calling thread, safe to call from any number of threads
+ *
+ * Params:
+ *  sharded - Pointer to sharded vector structure
+ *  item    - Item to push
+ *
+ * Returns:
+ *  BASICVECTOR_MEMORY_ERROR    - returned if sharded is null or the shard could not grow
+ *  BASICVECTOR_SUCCESS         - returned if everything went ok
+ */
+int basicvector_sharded_push(struct basicvector_sharded_s *sharded, void *item);
+
+/*
+ * Get count of items in all shards
+ *
+ * Shards are counted one by one, so pushes running at the same time may or may not be included.
+ *
+ * Params:
+ *  sharded - Pointer to sharded vector structure
+ *  result  - Pointer to variable that will receive the count
+ *
+ * Returns:
+ *  BASICVECTOR_MEMORY_ERROR        - returned if sharded is null
+ *  BASICVECTOR_INVALID_ARGUMENT    - returned if result is null
+ *  BASICVECTOR_SUCCESS             - returned if everything went ok
+ */
+int basicvector_sharded_length(struct basicvector_sharded_s *sharded, size_t *result);
+
+/*
+ * Call function on every item, shard by shard, holding the lock of the shard being visited
+ *
+ * Params:
+ *  sharded     - Pointer to sharded vector structure
+ *  function    - Function called with every item and user_data
+ *  user_data   - Context data for function
+ *
+ * Warning:
+ *  function must not push into the same sharded vector.
+ *
+ * Returns:
+ *  BASICVECTOR_MEMORY_ERROR        - returned if sharded is null
+ *  BASICVECTOR_INVALID_ARGUMENT    - returned if function is null
+ *  BASICVECTOR_SUCCESS             - returned if everything went ok
+ */
+int basicvector_sharded_for_each(
+    struct basicvector_sharded_s *sharded,
+    void (*function)(void *item, void *user_data),
+    void *user_data
+);
+
+/*
+ * Move items of all shards to the end of destination, shard after shard, leaving the shards empty
+ *
+ * Params:
+ *  sharded     - Pointer to sharded vector structure
+ *  destination - Pointer to vector receiving the items
+ *
+ * Returns:
+ *  BASICVECTOR_MEMORY_ERROR    - returned if sharded or destination is null or destination could not grow, items of shards not yet moved stay in them
+ *  BASICVECTOR_UNSUPPORTED     - returned if destination uses handles
+ *  BASICVECTOR_SUCCESS         - returned if everything went ok
+ */
+int basicvector_sharded_collect(struct basicvector_sharded_s *sharded, struct basicvector_s *destination);
+
+/*
+ * Free sharded vector together with its shards
+ *
+ * Params:
+ *  sharded                 - Pointer to sharded vector structure
+ *  deallocation_function   - Function callback used to deallocate every item, see basicvector_free. If passed null, the execution of the callback will be omitted.
+ *  user_data               - Context data for deallocation function
+ *
+ * Warning:
+ *  No other thread may use the sharded vector while it is being freed.
+ *
+ * Returns:
+ *  BASICVECTOR_MEMORY_ERROR    - returned if sharded is null
+ *  BASICVECTOR_SUCCESS         - returned if everything went ok
+ */
+int basicvector_sharded_free(
+    struct basicvector_sharded_s *sharded,
+    void (*deallocation_function)(void *item, void *user_data),
+    void *user_data
+);
+
+/*
+ * Get operation counters of the vector
+ *
+ * Params:
+ *  vector  - Pointer to vector structure
+ *  result  - Pointer to stats structure that will receive a copy of the counters
+ *
+ * Returns:
+ *  BASICVECTOR_MEMORY_ERROR        - returned if vector is null
+ *  BASICVECTOR_INVALID_ARGUMENT    - returned if result is null
+ *  BASICVECTOR_UNSUPPORTED         - returned if the library has been compiled without BASICVECTOR_STATS
+ *  BASICVECTOR_SUCCESS             - returned if everything went ok
+ */
+int basicvector_stats(struct basicvector_s *vector, struct basicvector_stats_s *result);
+
+/*
+ * Get memory used by the vector
+ *
+ * Params:
+ *  vector  - Pointer to vector structure
+ *  result  - Pointer to memory usage structure that will receive the report
+ *
+ * Returns:
+ *  BASICVECTOR_MEMORY_ERROR        - returned if vector is null
+ *  BASICVECTOR_INVALID_ARGUMENT    - returned if result is null
+ *  BASICVECTOR_SUCCESS             - returned if everything went ok
+ */
+int basicvector_memory_usage(struct basicvector_s *vector, struct basicvector_memory_usage_s *result);
+
+/*
+ * Get memory used by all live vectors of the process
+ *
+ * Maintained with atomic counters when the library is compiled with BASICVECTOR_ACCOUNTING defined. header_bytes
+ * and vector_count cover vectors created by basicvector_init and not yet freed, storage_bytes covers item storage of
+ * all vectors including ones initialized in place. slack_bytes, auxiliary_bytes and item_count are only reported per
+ * vector and are always 0.
+ *
+ * Params:
+ *  result  - Pointer to memory usage structure that will receive the report
+ *
+ * Returns:
+ *  BASICVECTOR_INVALID_ARGUMENT    - returned if result is null
+ *  BASICVECTOR_UNSUPPORTED         - returned if the library has been compiled without BASICVECTOR_ACCOUNTING
+ *  BASICVECTOR_SUCCESS             - returned if everything went ok
+ */
+int basicvector_memory_usage_total(struct basicvector_memory_usage_s *result);
+
+#ifdef BASICVECTOR_INLINE
+/*
+ * Get count of total items inside the vector without any checks
+ *
+ * Slots tombstoned by basicvector_remove_deferred are counted until the vector is flushed.
+ *
+ * Params:
+ *  vector  - Pointer to vector structure, must not be null
+ *
+ * Returns:
+ *  Count of items inside the vector
+ */
+static inline size_t basicvector_len_unchecked(const struct basicvector_s *vector) {
+    return vector->length;
+}
+
+/*
+ * Get item from basicvector structure without any checks
+ *
+ * Params:
+ *  vector  - Pointer to vector structure, must not be null
+ *  index   - Index of item, must be between 0 and length - 1
+ *
+ * Returns:
+ *  Item under given index
+ */
+static inline void *basicvector_at_unchecked(const struct basicvector_s *vector, size_t index) {
+    return vector->items[index];
+}
+#endif
 
 #endif //BASICVECTOR_VECTOR_H_
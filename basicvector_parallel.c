@@ -0,0 +1,1110 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include "basicvector.h"
+
+// Ranges shorter than this are processed on the calling thread, as waking workers would cost more than the work itself
+#define BASICVECTOR_PARALLEL_MIN_LENGTH 4096
+
+// Ranges are split until every participating thread could get about this many pieces
+#define BASICVECTOR_PARALLEL_SPLITS_PER_THREAD 16
+
+#define BASICVECTOR_PARALLEL_MIN_CHUNK 256
+
+// Capacity of every work-stealing deque, lazy splitting only needs about log2(length / grain) entries
+#define BASICVECTOR_DEQUE_CAPACITY 256
+
+#define BASICVECTOR_CACHE_LINE 64
+
+/*
+ * Chase-Lev work-stealing deque of [begin, end) ranges
+ *
+ * The owning thread pushes and takes at the bottom, other threads steal from the top. Ranges are
+ * stored as two arrays of atomics, so a thief racing with the owner never reads a torn range.
+ */
+struct basicvector_internal_deque_s {
+    _Alignas(BASICVECTOR_CACHE_LINE) atomic_long top;
+    _Alignas(BASICVECTOR_CACHE_LINE) atomic_long bottom;
+    atomic_size_t begins[BASICVECTOR_DEQUE_CAPACITY];
+    atomic_size_t ends[BASICVECTOR_DEQUE_CAPACITY];
+};
+
+/*
+ * Work executed by the pool, run is called on disjoint ranges covering [0, length)
+ */
+struct basicvector_internal_job_s {
+    void (*run)(size_t begin, size_t end, void *context);
+    void *context;
+    size_t granularity;
+    size_t grain;
+    atomic_size_t remaining_items;
+};
+
+struct basicvector_pool_s {
+    int thread_count;
+    pthread_t *threads;
+
+    // One deque per worker, the last one belongs to the thread submitting the job
+    struct basicvector_internal_deque_s *deques;
+
+    pthread_mutex_t mutex;
+    pthread_cond_t job_available;
+    pthread_cond_t job_finished;
+    pthread_mutex_t submit_mutex;
+    struct basicvector_internal_job_s *job;
+    unsigned long generation;
+    int busy_workers;
+    bool shutting_down;
+
+    // Callers that have taken the pool as default and not finished their operation yet, guarded by mutex
+    int users;
+    pthread_cond_t released;
+};
+
+struct basicvector_internal_worker_s {
+    struct basicvector_pool_s *pool;
+    int index;
+};
+
+static struct basicvector_pool_s *basicvector_internal_builtin_pool = NULL;
+static pthread_once_t basicvector_internal_builtin_pool_once = PTHREAD_ONCE_INIT;
+static _Atomic(struct basicvector_pool_s *) basicvector_internal_default_pool = NULL;
+// Taken when the default pool is acquired or replaced, so that a pool cannot be freed between the two
+static pthread_mutex_t basicvector_internal_default_pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Set on pool workers and on a thread taking part in a job, parallel operations called there run inline
+static _Thread_local bool basicvector_internal_inside_job = false;
+
+static bool basicvector_internal_deque_push(struct basicvector_internal_deque_s *deque, size_t begin, size_t end) {
+    long bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+    long top = atomic_load_explicit(&deque->top, memory_order_acquire);
+
+    if (bottom - top >= BASICVECTOR_DEQUE_CAPACITY) {
+        return false;
+    }
+
+    atomic_store_explicit(&deque->begins[bottom % BASICVECTOR_DEQUE_CAPACITY], begin, memory_order_relaxed);
+    atomic_store_explicit(&deque->ends[bottom % BASICVECTOR_DEQUE_CAPACITY], end, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+
+    return true;
+}
+
+static bool basicvector_internal_deque_take(struct basicvector_internal_deque_s *deque, size_t *begin, size_t *end) {
+    long bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed) - 1;
+    atomic_store_explicit(&deque->bottom, bottom, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    long top = atomic_load_explicit(&deque->top, memory_order_relaxed);
+
+    if (top > bottom) {
+        atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+        return false;
+    }
+
+    *begin = atomic_load_explicit(&deque->begins[bottom % BASICVECTOR_DEQUE_CAPACITY], memory_order_relaxed);
+    *end = atomic_load_explicit(&deque->ends[bottom % BASICVECTOR_DEQUE_CAPACITY], memory_order_relaxed);
+
+    if (top == bottom) {
+        // Last range, race against thieves for it
+        bool won = atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1, memory_order_seq_cst, memory_order_relaxed);
+        atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+        return won;
+    }
+
+    return true;
+}
+
+static bool basicvector_internal_deque_steal(struct basicvector_internal_deque_s *deque, size_t *begin, size_t *end) {
+    long top = atomic_load_explicit(&deque->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    long bottom = atomic_load_explicit(&deque->bottom, memory_order_acquire);
+
+    if (top >= bottom) {
+        return false;
+    }
+
+    *begin = atomic_load_explicit(&deque->begins[top % BASICVECTOR_DEQUE_CAPACITY], memory_order_relaxed);
+    *end = atomic_load_explicit(&deque->ends[top % BASICVECTOR_DEQUE_CAPACITY], memory_order_relaxed);
+
+    return atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1, memory_order_seq_cst, memory_order_relaxed);
+}
+
+/*
+ * Processes given range, lazily splitting it in halves that other threads can steal
+ *
+ * Splitting stops at job->grain, so expensive parts of the vector end up spread across threads
+ * no matter where they are, while cheap ones are processed without further splitting.
+ */
+static void basicvector_internal_job_process(
+    struct basicvector_internal_job_s *job,
+    struct basicvector_internal_deque_s *deque,
+    size_t begin,
+    size_t end
+) {
+    while (end - begin > job->grain) {
+        size_t middle = begin + (end - begin) / 2 / job->granularity * job->granularity;
+
+        if (middle == begin || !basicvector_internal_deque_push(deque, middle, end)) {
+            break;
+        }
+
+        end = middle;
+    }
+
+    job->run(begin, end, job->context);
+
+    atomic_fetch_sub_explicit(&job->remaining_items, end - begin, memory_order_acq_rel);
+}
+
+/*
+ * Works on the job until every item has been processed, first taking own ranges, then stealing
+ */
+static void basicvector_internal_job_work(struct basicvector_pool_s *pool, struct basicvector_internal_job_s *job, int index) {
+    struct basicvector_internal_deque_s *deque = &pool->deques[index];
+    int participants = pool->thread_count + 1;
+    unsigned int victim = (unsigned int) index;
+    size_t begin;
+    size_t end;
+
+    while (atomic_load_explicit(&job->remaining_items, memory_order_acquire) > 0) {
+        if (basicvector_internal_deque_take(deque, &begin, &end)) {
+            basicvector_internal_job_process(job, deque, begin, end);
+            continue;
+        }
+
+        bool stolen = false;
+
+        for (int attempt = 1; attempt < participants; attempt++) {
+            victim = (victim + 1) % (unsigned int) participants;
+
+            if (victim != (unsigned int) index && basicvector_internal_deque_steal(&pool->deques[victim], &begin, &end)) {
+                stolen = true;
+                break;
+            }
+        }
+
+        if (stolen) {
+            basicvector_internal_job_process(job, deque, begin, end);
+        } else {
+            sched_yield();
+        }
+    }
+}
+
+static void *basicvector_internal_pool_worker(void *argument) {
+    struct basicvector_internal_worker_s *worker = argument;
+    struct basicvector_pool_s *pool = worker->pool;
+    int index = worker->index;
+    unsigned long seen_generation = 0;
+
+    free(worker);
+
+    basicvector_internal_inside_job = true;
+
+    pthread_mutex_lock(&pool->mutex);
+
+    while (1) {
+        while (pool->generation == seen_generation && !pool->shutting_down) {
+            pthread_cond_wait(&pool->job_available, &pool->mutex);
+        }
+
+        if (pool->shutting_down) {
+            break;
+        }
+
+        seen_generation = pool->generation;
+        struct basicvector_internal_job_s *job = pool->job;
+
+        // Woken up too late, the job has already been finished by others
+        if (job == NULL) {
+            continue;
+        }
+
+        pool->busy_workers++;
+
+        pthread_mutex_unlock(&pool->mutex);
+        basicvector_internal_job_work(pool, job, index);
+        pthread_mutex_lock(&pool->mutex);
+
+        if (--pool->busy_workers == 0) {
+            pthread_cond_signal(&pool->job_finished);
+        }
+    }
+
+    pthread_mutex_unlock(&pool->mutex);
+
+    return NULL;
+}
+
+int basicvector_pool_create(struct basicvector_pool_s **pool, int thread_count) {
+    if (pool == NULL) return BASICVECTOR_INVALID_ARGUMENT;
+
+    if (thread_count < 0) {
+        long processors = sysconf(_SC_NPROCESSORS_ONLN);
+
+        // The submitting thread works as well, so one thread less is needed
+        thread_count = processors > 1 ? (int) processors - 1 : 0;
+    }
+
+    struct basicvector_pool_s *new_pool = malloc(sizeof(struct basicvector_pool_s));
+
+    if (new_pool == NULL) {
+        return BASICVECTOR_MEMORY_ERROR;
+    }
+
+    new_pool->thread_count = 0;
+    new_pool->threads = malloc(sizeof(pthread_t) * (size_t) (thread_count > 0 ? thread_count : 1));
+    new_pool->deques = aligned_alloc(BASICVECTOR_CACHE_LINE, sizeof(struct basicvector_internal_deque_s) * (size_t) (thread_count + 1));
+
+    if (new_pool->threads == NULL || new_pool->deques == NULL) {
+        free(new_pool->threads);
+        free(new_pool->deques);
+        free(new_pool);
+        return BASICVECTOR_MEMORY_ERROR;
+    }
+
+    for (int i = 0; i <= thread_count; i++) {
+        atomic_init(&new_pool->deques[i].top, 0);
+        atomic_init(&new_pool->deques[i].bottom, 0);
+    }
+
+    pthread_mutex_init(&new_pool->mutex, NULL);
+    pthread_cond_init(&new_pool->job_available, NULL);
+    pthread_cond_init(&new_pool->job_finished, NULL);
+    pthread_mutex_init(&new_pool->submit_mutex, NULL);
+    pthread_cond_init(&new_pool->released, NULL);
+    new_pool->users = 0;
+    new_pool->job = NULL;
+    new_pool->generation = 0;
+    new_pool->busy_workers = 0;
+    new_pool->shutting_down = false;
+
+    for (int i = 0; i < thread_count; i++) {
+        struct basicvector_internal_worker_s *worker = malloc(sizeof(struct basicvector_internal_worker_s));
+
+        if (worker == NULL) {
+            break;
+        }
+
+        worker->pool = new_pool;
+        worker->index = i;
+
+        if (pthread_create(&new_pool->threads[i], NULL, basicvector_internal_pool_worker, worker) != 0) {
+            free(worker);
+            break;
+        }
+
+        new_pool->thread_count++;
+    }
+
+    // Workers that failed to start leave their deques unused, the submitting thread takes the next free one
+    *pool = new_pool;
+
+    return BASICVECTOR_SUCCESS;
+}
+
+int basicvector_pool_free(struct basicvector_pool_s *pool) {
+    if (pool == NULL) return BASICVECTOR_MEMORY_ERROR;
+
+    pthread_mutex_lock(&basicvector_internal_default_pool_mutex);
+    struct basicvector_pool_s *expected = pool;
+    atomic_compare_exchange_strong(&basicvector_internal_default_pool, &expected, NULL);
+    pthread_mutex_unlock(&basicvector_internal_default_pool_mutex);
+
+    // No new user can take the pool any more, waits for operations that already have
+    pthread_mutex_lock(&pool->mutex);
+    while (pool->users > 0) {
+        pthread_cond_wait(&pool->released, &pool->mutex);
+    }
+    pthread_mutex_unlock(&pool->mutex);
+
+    pthread_mutex_lock(&pool->submit_mutex);
+
+    pthread_mutex_lock(&pool->mutex);
+    pool->shutting_down = true;
+    pthread_cond_broadcast(&pool->job_available);
+    pthread_mutex_unlock(&pool->mutex);
+
+    for (int i = 0; i < pool->thread_count; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    pthread_mutex_unlock(&pool->submit_mutex);
+
+    pthread_mutex_destroy(&pool->mutex);
+    pthread_cond_destroy(&pool->job_available);
+    pthread_cond_destroy(&pool->job_finished);
+    pthread_mutex_destroy(&pool->submit_mutex);
+    pthread_cond_destroy(&pool->released);
+
+    free(pool->threads);
+    free(pool->deques);
+    free(pool);
+
+    return BASICVECTOR_SUCCESS;
+}
+
+int basicvector_pool_set_default(struct basicvector_pool_s *pool) {
+    pthread_mutex_lock(&basicvector_internal_default_pool_mutex);
+    atomic_store(&basicvector_internal_default_pool, pool);
+    pthread_mutex_unlock(&basicvector_internal_default_pool_mutex);
+
+    return BASICVECTOR_SUCCESS;
+}
+
+int basicvector_pool_thread_count(struct basicvector_pool_s *pool, int *result) {
+    if (pool == NULL) return BASICVECTOR_MEMORY_ERROR;
+    if (result == NULL) return BASICVECTOR_INVALID_ARGUMENT;
+
+    *result = pool->thread_count;
+
+    return BASICVECTOR_SUCCESS;
+}
+
+static void basicvector_internal_builtin_pool_start() {
+    if (basicvector_pool_create(&basicvector_internal_builtin_pool, -1) != BASICVECTOR_SUCCESS) {
+        basicvector_internal_builtin_pool = NULL;
+    }
+}
+
+/*
+ * Takes the default pool for one operation, basicvector_pool_free waits until it is released
+ */
+static struct basicvector_pool_s *basicvector_internal_pool_acquire() {
+    pthread_mutex_lock(&basicvector_internal_default_pool_mutex);
+
+    struct basicvector_pool_s *pool = atomic_load(&basicvector_internal_default_pool);
+
+    if (pool == NULL) {
+        pthread_once(&basicvector_internal_builtin_pool_once, basicvector_internal_builtin_pool_start);
+        pool = basicvector_internal_builtin_pool;
+    }
+
+    if (pool != NULL) {
+        pthread_mutex_lock(&pool->mutex);
+        pool->users++;
+        pthread_mutex_unlock(&pool->mutex);
+    }
+
+    pthread_mutex_unlock(&basicvector_internal_default_pool_mutex);
+
+    return pool;
+}
+
+static void basicvector_internal_pool_release(struct basicvector_pool_s *pool) {
+    pthread_mutex_lock(&pool->mutex);
+
+    if (--pool->users == 0) {
+        pthread_cond_broadcast(&pool->released);
+    }
+
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+/*
+ * Runs run over [0, length) using the default pool and the calling thread, returns once every item has been processed
+ *
+ * Every range passed to run starts at a multiple of granularity. The pool runs one job at a time. Operations called
+ * from inside a job (nested ones) or while the pool is busy with another caller's job run on the calling thread
+ * alone instead of waiting, which would deadlock in the nested case.
+ */
+static void basicvector_internal_parallel_run(
+    size_t length,
+    size_t granularity,
+    void (*run)(size_t begin, size_t end, void *context),
+    void *context
+) {
+    if (length == 0) {
+        return;
+    }
+
+    if (length < BASICVECTOR_PARALLEL_MIN_LENGTH || basicvector_internal_inside_job) {
+        run(0, length, context);
+        return;
+    }
+
+    struct basicvector_pool_s *pool = basicvector_internal_pool_acquire();
+
+    if (pool == NULL) {
+        run(0, length, context);
+        return;
+    }
+
+    if (pool->thread_count == 0 || pthread_mutex_trylock(&pool->submit_mutex) != 0) {
+        basicvector_internal_pool_release(pool);
+        run(0, length, context);
+        return;
+    }
+
+    size_t grain = length / ((size_t) (pool->thread_count + 1) * BASICVECTOR_PARALLEL_SPLITS_PER_THREAD);
+    if (grain < BASICVECTOR_PARALLEL_MIN_CHUNK) grain = BASICVECTOR_PARALLEL_MIN_CHUNK;
+    if (grain < granularity) grain = granularity;
+
+    struct basicvector_internal_job_s job = {
+        .run = run,
+        .context = context,
+        .granularity = granularity,
+        .grain = grain,
+    };
+    atomic_init(&job.remaining_items, length);
+
+    pthread_mutex_lock(&pool->mutex);
+    pool->job = &job;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->job_available);
+    pthread_mutex_unlock(&pool->mutex);
+
+    int index = pool->thread_count;
+
+    basicvector_internal_inside_job = true;
+    basicvector_internal_job_process(&job, &pool->deques[index], 0, length);
+    basicvector_internal_job_work(pool, &job, index);
+    basicvector_internal_inside_job = false;
+
+    pthread_mutex_lock(&pool->mutex);
+    while (pool->busy_workers > 0) {
+        pthread_cond_wait(&pool->job_finished, &pool->mutex);
+    }
+    pool->job = NULL;
+    pthread_mutex_unlock(&pool->mutex);
+
+    pthread_mutex_unlock(&pool->submit_mutex);
+
+    basicvector_internal_pool_release(pool);
+}
+
+int basicvector_for_each(
+    struct basicvector_s *vector,
+    void (*function)(void *item, void *user_data),
+    void *user_data
+) {
+    if (vector == NULL) return BASICVECTOR_MEMORY_ERROR;
+    if (function == NULL) return BASICVECTOR_INVALID_ARGUMENT;
+
+    // Pending deferred removals are dropped first, so that only live items are visited
+    basicvector_flush(vector);
+
+    for (size_t i = 0; i < vector->length; i++) {
+        function(vector->items[i], user_data);
+    }
+
+    return BASICVECTOR_SUCCESS;
+}
+
+struct basicvector_internal_for_each_context_s {
+    void **items;
+    void (*function)(void *item, void *user_data);
+    void *user_data;
+};
+
+static void basicvector_internal_for_each_run(size_t begin, size_t end, void *context) {
+    struct basicvector_internal_for_each_context_s *for_each = context;
+
+    for (size_t i = begin; i < end; i++) {
+        for_each->function(for_each->items[i], for_each->user_data);
+    }
+}
+
+int basicvector_parallel_for_each(
+    struct basicvector_s *vector,
+    void (*function)(void *item, void *user_data),
+    void *user_data
+) {
+    if (vector == NULL) return BASICVECTOR_MEMORY_ERROR;
+    if (function == NULL) return BASICVECTOR_INVALID_ARGUMENT;
+
+    basicvector_flush(vector);
+
+    struct basicvector_internal_for_each_context_s context = {
+        .items = vector->items,
+        .function = function,
+        .user_data = user_data,
+    };
+
+    basicvector_internal_parallel_run(vector->length, 1, basicvector_internal_for_each_run, &context);
+
+    return BASICVECTOR_SUCCESS;
+}
+
+struct basicvector_internal_map_context_s {
+    void **items;
+    void **mapped_items;
+    void *(*map_function)(void *item, void *user_data);
+    void *user_data;
+};
+
+static void basicvector_internal_map_run(size_t begin, size_t end, void *context) {
+    struct basicvector_internal_map_context_s *map = context;
+
+    for (size_t i = begin; i < end; i++) {
+        map->mapped_items[i] = map->map_function(map->items[i], map->user_data);
+    }
+}
+
+int basicvector_map_into(
+    struct basicvector_s *vector,
+    struct basicvector_s **result,
+    void *(*map_function)(void *item, void *user_data),
+    void *user_data
+) {
+    if (vector == NULL) return BASICVECTOR_MEMORY_ERROR;
+    if (result == NULL || map_function == NULL) return BASICVECTOR_INVALID_ARGUMENT;
+
+    basicvector_flush(vector);
+
+    struct basicvector_s *mapped;
+
+    if (basicvector_init(&mapped) != BASICVECTOR_SUCCESS) {
+        return BASICVECTOR_MEMORY_ERROR;
+    }
+
+    // Setting the last item sizes the new vector in a single allocation, the rest is filled in place
+    if (vector->length > 0 && basicvector_set64(mapped, vector->length - 1, NULL, NULL, NULL) != BASICVECTOR_SUCCESS) {
+        basicvector_free(mapped, NULL, NULL);
+        return BASICVECTOR_MEMORY_ERROR;
+    }
+
+    struct basicvector_internal_map_context_s context = {
+        .items = vector->items,
+        .mapped_items = mapped->items,
+        .map_function = map_function,
+        .user_data = user_data,
+    };
+
+    basicvector_internal_parallel_run(vector->length, 1, basicvector_internal_map_run, &context);
+
+    *result = mapped;
+
+    return BASICVECTOR_SUCCESS;
+}
+
+struct basicvector_internal_reduce_context_s {
+    void **items;
+    void **partial_results;
+    size_t chunk_size;
+    void *initial_value;
+    void *(*reduce_function)(void *accumulator, void *item, void *user_data);
+    void *user_data;
+};
+
+static void basicvector_internal_reduce_run(size_t begin, size_t end, void *context) {
+    struct basicvector_internal_reduce_context_s *reduce = context;
+
+    // Ranges handed out by the pool start at chunk boundaries and may span several chunks
+    for (size_t chunk_begin = begin; chunk_begin < end; chunk_begin += reduce->chunk_size) {
+        size_t chunk_end = end - chunk_begin < reduce->chunk_size ? end : chunk_begin + reduce->chunk_size;
+        void *accumulator = reduce->initial_value;
+
+        for (size_t i = chunk_begin; i < chunk_end; i++) {
+            accumulator = reduce->reduce_function(accumulator, reduce->items[i], reduce->user_data);
+        }
+
+        reduce->partial_results[chunk_begin / reduce->chunk_size] = accumulator;
+    }
+}
+
+int basicvector_reduce_parallel(
+    struct basicvector_s *vector,
+    void **result,
+    void *initial_value,
+    void *(*reduce_function)(void *accumulator, void *item, void *user_data),
+    void *(*combine_function)(void *left, void *right, void *user_data),
+    void *user_data
+) {
+    if (vector == NULL) return BASICVECTOR_MEMORY_ERROR;
+    if (result == NULL || reduce_function == NULL || combine_function == NULL) return BASICVECTOR_INVALID_ARGUMENT;
+
+    basicvector_flush(vector);
+
+    size_t length = vector->length;
+    size_t chunk_size = BASICVECTOR_PARALLEL_MIN_CHUNK;
+    size_t chunk_count = (length + chunk_size - 1) / chunk_size;
+
+    void **partial_results = malloc(sizeof(void *) * (chunk_count > 0 ? chunk_count : 1));
+
+    if (partial_results == NULL) {
+        return BASICVECTOR_MEMORY_ERROR;
+    }
+
+    struct basicvector_internal_reduce_context_s context = {
+        .items = vector->items,
+        .partial_results = partial_results,
+        .chunk_size = chunk_size,
+        .initial_value = initial_value,
+        .reduce_function = reduce_function,
+        .user_data = user_data,
+    };
+
+    basicvector_internal_parallel_run(length, chunk_size, basicvector_internal_reduce_run, &context);
+
+    // Every partial result already starts from initial_value, so it is only returned as such for an empty vector
+    void *accumulator = chunk_count > 0 ? partial_results[0] : initial_value;
+
+    for (size_t i = 1; i < chunk_count; i++) {
+        accumulator = combine_function(accumulator, partial_results[i], user_data);
+    }
+
+    free(partial_results);
+
+    *result = accumulator;
+
+    return BASICVECTOR_SUCCESS;
+}
+
+struct basicvector_internal_free_context_s {
+    void **items;
+    void (*deallocation_function)(void *item, void *user_data);
+    void *user_data;
+};
+
+static void basicvector_internal_free_run(size_t begin, size_t end, void *context) {
+    struct basicvector_internal_free_context_s *free_context = context;
+
+    for (size_t i = begin; i < end; i++) {
+        free_context->deallocation_function(free_context->items[i], free_context->user_data);
+    }
+}
+
+int basicvector_free_parallel(
+    struct basicvector_s *vector,
+    void (*deallocation_function)(void *item, void *user_data),
+    void *user_data
+) {
+    if (vector == NULL) return BASICVECTOR_MEMORY_ERROR;
+
+    basicvector_flush(vector);
+
+    if (deallocation_function != NULL) {
+        struct basicvector_internal_free_context_s context = {
+            .items = vector->items,
+            .deallocation_function = deallocation_function,
+            .user_data = user_data,
+        };
+
+        basicvector_internal_parallel_run(vector->length, 1, basicvector_internal_free_run, &context);
+    }
+
+    return basicvector_free(vector, NULL, NULL);
+}
+
+struct basicvector_internal_reclaim_s {
+    struct basicvector_s *vector;
+    void (*deallocation_function)(void *item, void *user_data);
+    void *user_data;
+    struct basicvector_internal_reclaim_s *next;
+};
+
+static pthread_mutex_t basicvector_internal_reclaimer_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t basicvector_internal_reclaimer_queued = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t basicvector_internal_reclaimer_drained = PTHREAD_COND_INITIALIZER;
+static struct basicvector_internal_reclaim_s *basicvector_internal_reclaimer_head = NULL;
+static struct basicvector_internal_reclaim_s *basicvector_internal_reclaimer_tail = NULL;
+static bool basicvector_internal_reclaimer_started = false;
+static bool basicvector_internal_reclaimer_busy = false;
+
+static void *basicvector_internal_reclaimer(void *argument) {
+    (void) argument;
+
+    pthread_mutex_lock(&basicvector_internal_reclaimer_mutex);
+
+    while (1) {
+        while (basicvector_internal_reclaimer_head == NULL) {
+            pthread_cond_wait(&basicvector_internal_reclaimer_queued, &basicvector_internal_reclaimer_mutex);
+        }
+
+        struct basicvector_internal_reclaim_s *reclaim = basicvector_internal_reclaimer_head;
+
+        basicvector_internal_reclaimer_head = reclaim->next;
+        if (basicvector_internal_reclaimer_head == NULL) basicvector_internal_reclaimer_tail = NULL;
+        basicvector_internal_reclaimer_busy = true;
+
+        pthread_mutex_unlock(&basicvector_internal_reclaimer_mutex);
+        basicvector_free(reclaim->vector, reclaim->deallocation_function, reclaim->user_data);
+        free(reclaim);
+        pthread_mutex_lock(&basicvector_internal_reclaimer_mutex);
+
+        basicvector_internal_reclaimer_busy = false;
+
+        if (basicvector_internal_reclaimer_head == NULL) {
+            pthread_cond_broadcast(&basicvector_internal_reclaimer_drained);
+        }
+    }
+
+    return NULL;
+}
+
+int basicvector_free_background(
+    struct basicvector_s *vector,
+    void (*deallocation_function)(void *item, void *user_data),
+    void *user_data
+) {
+    if (vector == NULL) return BASICVECTOR_MEMORY_ERROR;
+
+    struct basicvector_internal_reclaim_s *reclaim = malloc(sizeof(struct basicvector_internal_reclaim_s));
+
+    if (reclaim == NULL) {
+        return BASICVECTOR_MEMORY_ERROR;
+    }
+
+    reclaim->vector = vector;
+    reclaim->deallocation_function = deallocation_function;
+    reclaim->user_data = user_data;
+    reclaim->next = NULL;
+
+    pthread_mutex_lock(&basicvector_internal_reclaimer_mutex);
+
+    if (!basicvector_internal_reclaimer_started) {
+        pthread_t thread;
+
+        if (pthread_create(&thread, NULL, basicvector_internal_reclaimer, NULL) != 0) {
+            pthread_mutex_unlock(&basicvector_internal_reclaimer_mutex);
+            free(reclaim);
+            return BASICVECTOR_MEMORY_ERROR;
+        }
+
+        // The reclaimer lives as long as the process, nobody joins it
+        pthread_detach(thread);
+        basicvector_internal_reclaimer_started = true;
+    }
+
+    if (basicvector_internal_reclaimer_tail != NULL) {
+        basicvector_internal_reclaimer_tail->next = reclaim;
+    } else {
+        basicvector_internal_reclaimer_head = reclaim;
+    }
+
+    basicvector_internal_reclaimer_tail = reclaim;
+
+    pthread_cond_signal(&basicvector_internal_reclaimer_queued);
+    pthread_mutex_unlock(&basicvector_internal_reclaimer_mutex);
+
+    return BASICVECTOR_SUCCESS;
+}
+
+int basicvector_free_background_wait(void) {
+    pthread_mutex_lock(&basicvector_internal_reclaimer_mutex);
+
+    while (basicvector_internal_reclaimer_head != NULL || basicvector_internal_reclaimer_busy) {
+        pthread_cond_wait(&basicvector_internal_reclaimer_drained, &basicvector_internal_reclaimer_mutex);
+    }
+
+    pthread_mutex_unlock(&basicvector_internal_reclaimer_mutex);
+
+    return BASICVECTOR_SUCCESS;
+}
+
+struct basicvector_internal_find_context_s {
+    void **items;
+    bool (*search_function)(void *item, void *user_data);
+    void *user_data;
+    atomic_size_t found_index;
+};
+
+static void basicvector_internal_find_run(size_t begin, size_t end, void *context) {
+    struct basicvector_internal_find_context_s *find = context;
+
+    for (size_t i = begin; i < end; i++) {
+        // A match before this range has already been found, nothing here can be the first one
+        if (atomic_load_explicit(&find->found_index, memory_order_relaxed) <= i) {
+            return;
+        }
+
+        if (find->search_function(find->items[i], find->user_data)) {
+            size_t current = atomic_load_explicit(&find->found_index, memory_order_relaxed);
+
+            while (i < current && !atomic_compare_exchange_weak_explicit(&find->found_index, &current, i, memory_order_relaxed, memory_order_relaxed));
+
+            return;
+        }
+    }
+}
+
+int basicvector_parallel_find_index(
+    struct basicvector_s *vector,
+    size_t *result,
+    bool (*search_function)(void *item, void *user_data),
+    void *user_data
+) {
+    if (vector == NULL) return BASICVECTOR_MEMORY_ERROR;
+    if (result == NULL || search_function == NULL) return BASICVECTOR_INVALID_ARGUMENT;
+
+    basicvector_flush(vector);
+
+    struct basicvector_internal_find_context_s context = {
+        .items = vector->items,
+        .search_function = search_function,
+        .user_data = user_data,
+    };
+    atomic_init(&context.found_index, SIZE_MAX);
+
+    basicvector_internal_parallel_run(vector->length, 1, basicvector_internal_find_run, &context);
+
+    size_t found_index = atomic_load(&context.found_index);
+
+    if (found_index == SIZE_MAX) {
+        return BASICVECTOR_ITEM_NOT_FOUND;
+    }
+
+    *result = found_index;
+
+    return BASICVECTOR_SUCCESS;
+}
+
+// Runs sorted with insertion sort before merging starts
+#define BASICVECTOR_SORT_RUN_LENGTH 16
+
+struct basicvector_internal_sort_context_s {
+    void **source;
+    void **target;
+    size_t length;
+    size_t width;
+    int (*compare_function)(void *left, void *right, void *user_data);
+    void *user_data;
+};
+
+static void basicvector_internal_sort_runs(size_t begin, size_t end, void *context) {
+    struct basicvector_internal_sort_context_s *sort = context;
+    void **items = sort->source;
+
+    for (size_t i = begin + 1; i < end; i++) {
+        void *item = items[i];
+        size_t j = i;
+
+        // Items equal to the inserted one are not moved, which keeps the sort stable
+        while (j > begin && (j % BASICVECTOR_SORT_RUN_LENGTH) != 0 && sort->compare_function(items[j - 1], item, sort->user_data) > 0) {
+            items[j] = items[j - 1];
+            j--;
+        }
+
+        items[j] = item;
+    }
+}
+
+static void basicvector_internal_sort_merge(size_t begin, size_t end, void *context) {
+    struct basicvector_internal_sort_context_s *sort = context;
+    size_t width = sort->width;
+
+    // Every range starts at a pair boundary, so it holds whole pairs of sorted runs of given width
+    for (size_t pair_begin = begin; pair_begin < end; pair_begin += 2 * width) {
+        size_t middle = sort->length - pair_begin < width ? sort->length : pair_begin + width;
+        size_t pair_end = sort->length - middle < width ? sort->length : middle + width;
+        size_t left = pair_begin;
+        size_t right = middle;
+
+        for (size_t i = pair_begin; i < pair_end; i++) {
+            if (left < middle && (right >= pair_end || sort->compare_function(sort->source[right], sort->source[left], sort->user_data) >= 0)) {
+                sort->target[i] = sort->source[left++];
+            } else {
+                sort->target[i] = sort->source[right++];
+            }
+        }
+    }
+}
+
+int basicvector_sort(
+    struct basicvector_s *vector,
+    int (*compare_function)(void *left, void *right, void *user_data),
+    void *user_data
+) {
+    if (vector == NULL) return BASICVECTOR_MEMORY_ERROR;
+    if (compare_function == NULL) return BASICVECTOR_INVALID_ARGUMENT;
+    if (vector->handles != NULL) return BASICVECTOR_UNSUPPORTED;
+
+    basicvector_flush(vector);
+
+    size_t length = vector->length;
+
+    if (length < 2) {
+        return BASICVECTOR_SUCCESS;
+    }
+
+    void **buffer = malloc(sizeof(void *) * length);
+
+    if (buffer == NULL) {
+        return BASICVECTOR_MEMORY_ERROR;
+    }
+
+    struct basicvector_internal_sort_context_s context = {
+        .source = vector->items,
+        .target = buffer,
+        .length = length,
+        .compare_function = compare_function,
+        .user_data = user_data,
+    };
+
+    basicvector_internal_parallel_run(length, BASICVECTOR_SORT_RUN_LENGTH, basicvector_internal_sort_runs, &context);
+
+    // Bottom-up merge passes, every pass merges pairs of neighbouring runs in parallel
+    for (size_t width = BASICVECTOR_SORT_RUN_LENGTH; width < length; width *= 2) {
+        context.width = width;
+
+        basicvector_internal_parallel_run(length, 2 * width, basicvector_internal_sort_merge, &context);
+
+        void **swap = context.source;
+        context.source = context.target;
+        context.target = swap;
+    }
+
+    if (context.source != vector->items) {
+        memcpy(vector->items, context.source, sizeof(void *) * length);
+    }
+
+    // Null items have moved along with the rest
+    vector->occupancy.valid = false;
+
+    free(buffer);
+
+    return BASICVECTOR_SUCCESS;
+}
+
+/*
+ * Every shard sits on its own cache lines, so that threads pushing into neighbouring shards do not contend
+ */
+struct basicvector_internal_shard_s {
+    _Alignas(BASICVECTOR_CACHE_LINE) pthread_mutex_t mutex;
+    struct basicvector_s vector;
+};
+
+struct basicvector_sharded_s {
+    int shard_count;
+    struct basicvector_internal_shard_s *shards;
+};
+
+static atomic_uint basicvector_internal_thread_counter = 0;
+static _Thread_local unsigned basicvector_internal_thread_number = 0;
+
+/*
+ * Numbers threads in the order of their first push, so that consecutive threads land in different shards
+ */
+static unsigned basicvector_internal_current_thread_number() {
+    if (basicvector_internal_thread_number == 0) {
+        basicvector_internal_thread_number = atomic_fetch_add_explicit(&basicvector_internal_thread_counter, 1, memory_order_relaxed) + 1;
+    }
+
+    return basicvector_internal_thread_number;
+}
+
+int basicvector_sharded_init(struct basicvector_sharded_s **sharded, int shard_count) {
+    if (sharded == NULL) return BASICVECTOR_INVALID_ARGUMENT;
+
+    if (shard_count <= 0) {
+        long processors = sysconf(_SC_NPROCESSORS_ONLN);
+
+        shard_count = processors > 1 ? (int) processors : 1;
+    }
+
+    struct basicvector_sharded_s *new_sharded = malloc(sizeof(struct basicvector_sharded_s));
+
+    if (new_sharded == NULL) {
+        return BASICVECTOR_MEMORY_ERROR;
+    }
+
+    new_sharded->shard_count = shard_count;
+    new_sharded->shards = aligned_alloc(BASICVECTOR_CACHE_LINE, sizeof(struct basicvector_internal_shard_s) * (size_t) shard_count);
+
+    if (new_sharded->shards == NULL) {
+        free(new_sharded);
+        return BASICVECTOR_MEMORY_ERROR;
+    }
+
+    for (int i = 0; i < shard_count; i++) {
+        pthread_mutex_init(&new_sharded->shards[i].mutex, NULL);
+        basicvector_init_inplace(&new_sharded->shards[i].vector);
+    }
+
+    *sharded = new_sharded;
+
+    return BASICVECTOR_SUCCESS;
+}
+
+int basicvector_sharded_push(struct basicvector_sharded_s *sharded, void *item) {
+    if (sharded == NULL) return BASICVECTOR_MEMORY_ERROR;
+
+    struct basicvector_internal_shard_s *shard =
+        &sharded->shards[(basicvector_internal_current_thread_number() - 1) % (unsigned) sharded->shard_count];
+
+    pthread_mutex_lock(&shard->mutex);
+    int status = basicvector_push(&shard->vector, item);
+    pthread_mutex_unlock(&shard->mutex);
+
+    return status;
+}
+
+int basicvector_sharded_length(struct basicvector_sharded_s *sharded, size_t *result) {
+    if (sharded == NULL) return BASICVECTOR_MEMORY_ERROR;
+    if (result == NULL) return BASICVECTOR_INVALID_ARGUMENT;
+
+    size_t length = 0;
+
+    for (int i = 0; i < sharded->shard_count; i++) {
+        size_t shard_length;
+
+        pthread_mutex_lock(&sharded->shards[i].mutex);
+        basicvector_length64(&sharded->shards[i].vector, &shard_length);
+        pthread_mutex_unlock(&sharded->shards[i].mutex);
+
+        length += shard_length;
+    }
+
+    *result = length;
+
+    return BASICVECTOR_SUCCESS;
+}
+
+int basicvector_sharded_for_each(
+    struct basicvector_sharded_s *sharded,
+    void (*function)(void *item, void *user_data),
+    void *user_data
+) {
+    if (sharded == NULL) return BASICVECTOR_MEMORY_ERROR;
+    if (function == NULL) return BASICVECTOR_INVALID_ARGUMENT;
+
+    for (int i = 0; i < sharded->shard_count; i++) {
+        pthread_mutex_lock(&sharded->shards[i].mutex);
+        basicvector_for_each(&sharded->shards[i].vector, function, user_data);
+        pthread_mutex_unlock(&sharded->shards[i].mutex);
+    }
+
+    return BASICVECTOR_SUCCESS;
+}
+
+int basicvector_sharded_collect(struct basicvector_sharded_s *sharded, struct basicvector_s *destination) {
+    if (sharded == NULL || destination == NULL) return BASICVECTOR_MEMORY_ERROR;
+
+    for (int i = 0; i < sharded->shard_count; i++) {
+        pthread_mutex_lock(&sharded->shards[i].mutex);
+        int status = basicvector_append_vector(destination, &sharded->shards[i].vector);
+        pthread_mutex_unlock(&sharded->shards[i].mutex);
+
+        // Items of shards collected so far stay in destination, the rest stay in their shards
+        if (status != BASICVECTOR_SUCCESS) {
+            return status;
+        }
+    }
+
+    return BASICVECTOR_SUCCESS;
+}
+
+int basicvector_sharded_free(
+    struct basicvector_sharded_s *sharded,
+    void (*deallocation_function)(void *item, void *user_data),
+    void *user_data
+) {
+    if (sharded == NULL) return BASICVECTOR_MEMORY_ERROR;
+
+    for (int i = 0; i < sharded->shard_count; i++) {
+        basicvector_free_inplace(&sharded->shards[i].vector, deallocation_function, user_data);
+        pthread_mutex_destroy(&sharded->shards[i].mutex);
+    }
+
+    free(sharded->shards);
+    free(sharded);
+
+    return BASICVECTOR_SUCCESS;
+}
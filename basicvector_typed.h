@@ -0,0 +1,191 @@
+#ifndef BASICVECTOR_TYPED_H_
+#define BASICVECTOR_TYPED_H_
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "basicvector.h"
+
+/*
+ * Type-specialized vectors storing items by value in contiguous storage
+ *
+ * BASICVECTOR_DEFINE(name, type) generates struct name_s and the following static functions,
+ * which follow the same status code conventions as their basicvector counterparts:
+ *
+ *  int name_init(struct name_s **vector)
+ *  int name_push(struct name_s *vector, type item)
+ *  int name_get(struct name_s *vector, int index, type *result)
+ *  int name_set(struct name_s *vector, int index, type item)
+ *  int name_remove(struct name_s *vector, int index)
+ *  int name_length(struct name_s *vector, int *result)
+ *  int name_find_index(struct name_s *vector, int *result, bool (*search_function)(const type *item, void *user_data), void *user_data)
+ *  int name_find(struct name_s *vector, type *result, bool (*search_function)(const type *item, void *user_data), void *user_data)
+ *  int name_free(struct name_s *vector)
+ *
+ * Items are copied into the vector, so there are no deallocation callbacks. Gaps created by
+ * name_set past the end of the vector are filled with zeroed items, and name_get and name_find zero their
+ * result when there is no such item, like basicvector_get and basicvector_find set it to null.
+ *
+ * Example:
+ *  BASICVECTOR_DEFINE(intvector, int)
+ *
+ *  struct intvector_s *vector;
+ *  intvector_init(&vector);
+ *  intvector_push(vector, 42);
+ */
+#define BASICVECTOR_DEFINE(name, type) \
+    struct name##_s { \
+        type *items; \
+        int length; \
+        int capacity; \
+    }; \
+    \
+    static inline int name##_internal_reserve(struct name##_s *vector, int required_capacity) { \
+        if (required_capacity <= vector->capacity) return BASICVECTOR_SUCCESS; \
+        \
+        int new_capacity = vector->capacity < 4 ? 4 : vector->capacity; \
+        \
+        while (new_capacity < required_capacity) { \
+            new_capacity = new_capacity > INT_MAX / 2 ? INT_MAX : new_capacity * 2; \
+        } \
+        \
+        type *new_items = realloc(vector->items, sizeof(type) * (size_t) new_capacity); \
+        \
+        if (new_items == NULL) return BASICVECTOR_MEMORY_ERROR; \
+        \
+        vector->items = new_items; \
+        vector->capacity = new_capacity; \
+        \
+        return BASICVECTOR_SUCCESS; \
+    } \
+    \
+    static inline int name##_init(struct name##_s **vector) { \
+        struct name##_s *new_vector = malloc(sizeof(struct name##_s)); \
+        \
+        if (new_vector == NULL) return BASICVECTOR_MEMORY_ERROR; \
+        \
+        new_vector->items = NULL; \
+        new_vector->length = 0; \
+        new_vector->capacity = 0; \
+        \
+        *vector = new_vector; \
+        \
+        return BASICVECTOR_SUCCESS; \
+    } \
+    \
+    static inline int name##_push(struct name##_s *vector, type item) { \
+        if (vector == NULL) return BASICVECTOR_MEMORY_ERROR; \
+        if (vector->length == INT_MAX) return BASICVECTOR_MEMORY_ERROR; \
+        \
+        if (name##_internal_reserve(vector, vector->length + 1) != BASICVECTOR_SUCCESS) { \
+            return BASICVECTOR_MEMORY_ERROR; \
+        } \
+        \
+        vector->items[vector->length++] = item; \
+        \
+        return BASICVECTOR_SUCCESS; \
+    } \
+    \
+    static inline int name##_get(struct name##_s *vector, int index, type *result) { \
+        if (vector == NULL) return BASICVECTOR_MEMORY_ERROR; \
+        if (result == NULL) return BASICVECTOR_INVALID_ARGUMENT; \
+        \
+        if (index < 0 || index >= vector->length) { \
+            memset(result, 0, sizeof(type)); \
+            return BASICVECTOR_ITEM_NOT_FOUND; \
+        } \
+        \
+        *result = vector->items[index]; \
+        \
+        return BASICVECTOR_SUCCESS; \
+    } \
+    \
+    static inline int name##_set(struct name##_s *vector, int index, type item) { \
+        if (vector == NULL) return BASICVECTOR_MEMORY_ERROR; \
+        if (index < 0) return BASICVECTOR_INVALID_INDEX; \
+        \
+        if (index >= vector->length) { \
+            if (index == INT_MAX || name##_internal_reserve(vector, index + 1) != BASICVECTOR_SUCCESS) { \
+                return BASICVECTOR_MEMORY_ERROR; \
+            } \
+            \
+            memset(&vector->items[vector->length], 0, sizeof(type) * (size_t) (index - vector->length)); \
+            vector->length = index + 1; \
+        } \
+        \
+        vector->items[index] = item; \
+        \
+        return BASICVECTOR_SUCCESS; \
+    } \
+    \
+    static inline int name##_remove(struct name##_s *vector, int index) { \
+        if (vector == NULL) return BASICVECTOR_MEMORY_ERROR; \
+        if (index < 0 || index >= vector->length) return BASICVECTOR_INVALID_INDEX; \
+        \
+        memmove(&vector->items[index], &vector->items[index + 1], sizeof(type) * (size_t) (vector->length - index - 1)); \
+        vector->length--; \
+        \
+        return BASICVECTOR_SUCCESS; \
+    } \
+    \
+    static inline int name##_length(struct name##_s *vector, int *result) { \
+        if (vector == NULL) return BASICVECTOR_MEMORY_ERROR; \
+        if (result == NULL) return BASICVECTOR_INVALID_ARGUMENT; \
+        \
+        *result = vector->length; \
+        \
+        return BASICVECTOR_SUCCESS; \
+    } \
+    \
+    static inline int name##_find_index( \
+        struct name##_s *vector, \
+        int *result, \
+        bool (*search_function)(const type *item, void *user_data), \
+        void *user_data \
+    ) { \
+        if (vector == NULL) return BASICVECTOR_MEMORY_ERROR; \
+        if (result == NULL || search_function == NULL) return BASICVECTOR_INVALID_ARGUMENT; \
+        \
+        for (int i = 0; i < vector->length; i++) { \
+            if (search_function(&vector->items[i], user_data)) { \
+                *result = i; \
+                return BASICVECTOR_SUCCESS; \
+            } \
+        } \
+        \
+        return BASICVECTOR_ITEM_NOT_FOUND; \
+    } \
+    \
+    static inline int name##_find( \
+        struct name##_s *vector, \
+        type *result, \
+        bool (*search_function)(const type *item, void *user_data), \
+        void *user_data \
+    ) { \
+        if (vector == NULL) return BASICVECTOR_MEMORY_ERROR; \
+        if (result == NULL) return BASICVECTOR_INVALID_ARGUMENT; \
+        \
+        int index; \
+        int status = name##_find_index(vector, &index, search_function, user_data); \
+        \
+        if (status != BASICVECTOR_SUCCESS) { \
+            memset(result, 0, sizeof(type)); \
+            return status; \
+        } \
+        \
+        *result = vector->items[index]; \
+        \
+        return BASICVECTOR_SUCCESS; \
+    } \
+    \
+    static inline int name##_free(struct name##_s *vector) { \
+        if (vector == NULL) return BASICVECTOR_MEMORY_ERROR; \
+        \
+        free(vector->items); \
+        free(vector); \
+        \
+        return BASICVECTOR_SUCCESS; \
+    }
+
+#endif //BASICVECTOR_TYPED_H_
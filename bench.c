@@ -0,0 +1,602 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/resource.h>
+#define BASICVECTOR_INLINE
+#include "basicvector.h"
+
+/*
+ * Microbenchmarks for basicvector.
+ *
+ * Usage:
+ *  bench [max_size] [csv|json]
+ *
+ * Every case is run on vectors of 10, 100, ... up to max_size items. Each case repeats its
+ * operation in growing batches until BENCH_MIN_TIME_NS elapsed, so that O(n) operations on
+ * large vectors still finish in reasonable time. A case also stops after BENCH_MAX_WALL_NS of
+ * wall time, which bounds untimed setup such as rebuilding the vector between rounds. Sizes
+ * whose vector build is predicted to take longer than BENCH_MAX_BUILD_NS are skipped (reported
+ * on stderr).
+ *
+ * Parallel cases run on a pool with one worker per online CPU except one. The skewed ones make
+ * the first items of the vector expensive, static_for_each_skewed splits the vector into equal
+ * parts per thread and shows what the work-stealing pool is compared against.
+ *
+ * Output is written to stdout, one row per (operation, size) pair.
+ */
+
+#define BENCH_MIN_TIME_NS 200000000LL
+#define BENCH_MAX_WALL_NS 2000000000LL
+#define BENCH_MAX_BUILD_NS 30000000000LL
+#define BENCH_MAX_OPS (1LL << 26)
+#define BENCH_SPARSE_STRIDE 16
+
+// In skewed parallel cases only the first 1/BENCH_SKEW_FRACTION of items is expensive
+#define BENCH_SKEW_FRACTION 8
+#define BENCH_SKEW_WORK 200
+
+enum bench_format_e {
+    BENCH_FORMAT_CSV,
+    BENCH_FORMAT_JSON
+};
+
+static enum bench_format_e bench_format = BENCH_FORMAT_CSV;
+static int bench_rows_printed = 0;
+static uint64_t bench_random_state = 0x9E3779B97F4A7C15ULL;
+static int bench_thread_count = 0;
+
+typedef long long (*bench_case_fn)(struct basicvector_s **vector, int size, long long ops, long long *done);
+
+struct bench_case_s {
+    char *name;
+    bench_case_fn run;
+};
+
+static long long bench_now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long) ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static long bench_peak_rss_kb() {
+    struct rusage usage;
+
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return -1;
+    }
+
+    return usage.ru_maxrss;
+}
+
+static uint64_t bench_random() {
+    bench_random_state ^= bench_random_state << 13;
+    bench_random_state ^= bench_random_state >> 7;
+    bench_random_state ^= bench_random_state << 17;
+    return bench_random_state;
+}
+
+// Items are never dereferenced, so fake non-null pointers avoid benchmarking malloc instead of the vector
+static void *bench_item(long long i) {
+    return (void *) (uintptr_t) (i + 1);
+}
+
+static bool bench_search_function(void *item, void *user_data) {
+    return item == user_data;
+}
+
+static void bench_fail(char *operation, int status) {
+    fprintf(stderr, "%s failed with status %d\n", operation, status);
+    exit(EXIT_FAILURE);
+}
+
+static struct basicvector_s *bench_build(int size) {
+    struct basicvector_s *vector;
+    int status = basicvector_init(&vector);
+
+    if (status != BASICVECTOR_SUCCESS) bench_fail("basicvector_init", status);
+
+    for (int i = 0; i < size; i++) {
+        status = basicvector_push(vector, bench_item(i));
+        if (status != BASICVECTOR_SUCCESS) bench_fail("basicvector_push", status);
+    }
+
+    return vector;
+}
+
+static void bench_rebuild(struct basicvector_s **vector, int size) {
+    basicvector_free(*vector, NULL, NULL);
+    *vector = bench_build(size);
+}
+
+static long long bench_case_push(struct basicvector_s **vector, int size, long long ops, long long *done) {
+    (void) vector;
+
+    long long elapsed = 0;
+    *done = 0;
+
+    while (*done < ops) {
+        struct basicvector_s *fresh;
+        basicvector_init(&fresh);
+
+        long long start = bench_now_ns();
+        for (int i = 0; i < size; i++) {
+            basicvector_push(fresh, bench_item(i));
+        }
+        elapsed += bench_now_ns() - start;
+
+        basicvector_free(fresh, NULL, NULL);
+        *done += size;
+    }
+
+    return elapsed;
+}
+
+static long long bench_case_get_sequential(struct basicvector_s **vector, int size, long long ops, long long *done) {
+    void *result;
+    int index = 0;
+
+    long long start = bench_now_ns();
+    for (long long i = 0; i < ops; i++) {
+        basicvector_get(*vector, index, &result);
+        if (++index == size) index = 0;
+    }
+    long long elapsed = bench_now_ns() - start;
+
+    *done = ops;
+    return elapsed;
+}
+
+static long long bench_case_get_random(struct basicvector_s **vector, int size, long long ops, long long *done) {
+    void *result;
+
+    long long start = bench_now_ns();
+    for (long long i = 0; i < ops; i++) {
+        basicvector_get(*vector, (int) (bench_random() % (uint64_t) size), &result);
+    }
+    long long elapsed = bench_now_ns() - start;
+
+    *done = ops;
+    return elapsed;
+}
+
+static long long bench_case_set_dense(struct basicvector_s **vector, int size, long long ops, long long *done) {
+    int index = 0;
+
+    long long start = bench_now_ns();
+    for (long long i = 0; i < ops; i++) {
+        basicvector_set(*vector, index, bench_item(i), NULL, NULL);
+        if (++index == size) index = 0;
+    }
+    long long elapsed = bench_now_ns() - start;
+
+    *done = ops;
+    return elapsed;
+}
+
+static long long bench_case_set_sparse(struct basicvector_s **vector, int size, long long ops, long long *done) {
+    (void) vector;
+
+    long long elapsed = 0;
+    *done = 0;
+
+    while (*done < ops) {
+        struct basicvector_s *fresh;
+        basicvector_init(&fresh);
+
+        long long start = bench_now_ns();
+        for (int index = 0; index < size; index += BENCH_SPARSE_STRIDE) {
+            basicvector_set(fresh, index, bench_item(index), NULL, NULL);
+        }
+        elapsed += bench_now_ns() - start;
+
+        basicvector_free(fresh, NULL, NULL);
+        *done += (size + BENCH_SPARSE_STRIDE - 1) / BENCH_SPARSE_STRIDE;
+    }
+
+    return elapsed;
+}
+
+enum bench_remove_position_e {
+    BENCH_REMOVE_HEAD,
+    BENCH_REMOVE_MIDDLE,
+    BENCH_REMOVE_TAIL,
+    BENCH_SWAP_REMOVE_HEAD
+};
+
+static long long bench_remove(struct basicvector_s **vector, int size, long long ops, long long *done, enum bench_remove_position_e position) {
+    long long elapsed = 0;
+    *done = 0;
+
+    while (*done < ops) {
+        // Never shrink the vector below half of its size, so the measured cost stays representative
+        long long count = ops - *done;
+        if (count > size - size / 2) count = size - size / 2;
+
+        int length = size;
+
+        long long start = bench_now_ns();
+        for (long long i = 0; i < count; i++) {
+            int index = 0;
+
+            if (position == BENCH_REMOVE_MIDDLE) index = length / 2;
+            else if (position == BENCH_REMOVE_TAIL) index = length - 1;
+
+            if (position == BENCH_SWAP_REMOVE_HEAD) basicvector_swap_remove(*vector, 0, NULL, NULL);
+            else basicvector_remove(*vector, index, NULL, NULL);
+
+            length--;
+        }
+        elapsed += bench_now_ns() - start;
+
+        bench_rebuild(vector, size);
+        *done += count;
+    }
+
+    return elapsed;
+}
+
+static long long bench_case_remove_head(struct basicvector_s **vector, int size, long long ops, long long *done) {
+    return bench_remove(vector, size, ops, done, BENCH_REMOVE_HEAD);
+}
+
+static long long bench_case_remove_middle(struct basicvector_s **vector, int size, long long ops, long long *done) {
+    return bench_remove(vector, size, ops, done, BENCH_REMOVE_MIDDLE);
+}
+
+static long long bench_case_remove_tail(struct basicvector_s **vector, int size, long long ops, long long *done) {
+    return bench_remove(vector, size, ops, done, BENCH_REMOVE_TAIL);
+}
+
+static long long bench_case_swap_remove_head(struct basicvector_s **vector, int size, long long ops, long long *done) {
+    return bench_remove(vector, size, ops, done, BENCH_SWAP_REMOVE_HEAD);
+}
+
+static long long bench_case_find(struct basicvector_s **vector, int size, long long ops, long long *done) {
+    void *result;
+    void *wanted = bench_item(size / 2);
+
+    long long start = bench_now_ns();
+    for (long long i = 0; i < ops; i++) {
+        basicvector_find(*vector, &result, bench_search_function, wanted);
+    }
+    long long elapsed = bench_now_ns() - start;
+
+    *done = ops;
+    return elapsed;
+}
+
+static long long bench_case_find_index(struct basicvector_s **vector, int size, long long ops, long long *done) {
+    int result;
+    void *wanted = bench_item(size / 2);
+
+    long long start = bench_now_ns();
+    for (long long i = 0; i < ops; i++) {
+        basicvector_find_index(*vector, &result, bench_search_function, wanted);
+    }
+    long long elapsed = bench_now_ns() - start;
+
+    *done = ops;
+    return elapsed;
+}
+
+static uint64_t bench_hash(void *item, void *user_data) {
+    (void) user_data;
+    return (uint64_t) (uintptr_t) item * 0x9E3779B97F4A7C15ULL;
+}
+
+static long long bench_case_find_by_hash_miss(struct basicvector_s **vector, int size, long long ops, long long *done) {
+    void *result;
+    void *wanted = bench_item(size + 1);
+    uint64_t hash = bench_hash(wanted, NULL);
+
+    basicvector_filter_enable(*vector, bench_hash, NULL);
+
+    long long start = bench_now_ns();
+    for (long long i = 0; i < ops; i++) {
+        basicvector_find_by_hash(*vector, &result, hash, bench_search_function, wanted);
+    }
+    long long elapsed = bench_now_ns() - start;
+
+    basicvector_filter_disable(*vector);
+
+    *done = ops;
+    return elapsed;
+}
+
+static long long bench_case_free(struct basicvector_s **vector, int size, long long ops, long long *done) {
+    long long elapsed = 0;
+    *done = 0;
+
+    while (*done < ops) {
+        long long start = bench_now_ns();
+        basicvector_free(*vector, NULL, NULL);
+        elapsed += bench_now_ns() - start;
+
+        *vector = bench_build(size);
+        *done += size;
+    }
+
+    return elapsed;
+}
+
+// Short-lived vectors fitting into inline storage, created and freed by the thousand regardless of size
+static long long bench_case_init_free_small(struct basicvector_s **vector, int size, long long ops, long long *done) {
+    (void) vector;
+    (void) size;
+
+    long long start = bench_now_ns();
+
+    for (*done = 0; *done < ops; (*done)++) {
+        struct basicvector_s *small;
+
+        if (basicvector_init(&small) != BASICVECTOR_SUCCESS) bench_fail("init", BASICVECTOR_MEMORY_ERROR);
+        basicvector_push(small, bench_item(*done));
+        basicvector_free(small, NULL, NULL);
+    }
+
+    return bench_now_ns() - start;
+}
+
+static int bench_compare(void *left, void *right, void *user_data) {
+    (void) user_data;
+    return (uintptr_t) left < (uintptr_t) right ? -1 : (uintptr_t) left > (uintptr_t) right;
+}
+
+// Scheduler tick: pop the first item and push a new one, the heap keeps its size
+static long long bench_heap_pop_push(struct basicvector_s **vector, int size, long long ops, long long *done, int arity) {
+    void *item;
+
+    basicvector_heapify(*vector, arity, bench_compare, NULL);
+
+    long long start = bench_now_ns();
+    for (long long i = 0; i < ops; i++) {
+        basicvector_heap_pop(*vector, &item, arity, bench_compare, NULL);
+        basicvector_heap_push(*vector, bench_item((long long) (bench_random() % (uint64_t) size)), arity, bench_compare, NULL);
+    }
+    long long elapsed = bench_now_ns() - start;
+
+    bench_rebuild(vector, size);
+
+    *done = ops;
+    return elapsed;
+}
+
+static long long bench_case_heap_pop_push_binary(struct basicvector_s **vector, int size, long long ops, long long *done) {
+    return bench_heap_pop_push(vector, size, ops, done, BASICVECTOR_HEAP_BINARY);
+}
+
+static long long bench_case_heap_pop_push_quaternary(struct basicvector_s **vector, int size, long long ops, long long *done) {
+    return bench_heap_pop_push(vector, size, ops, done, BASICVECTOR_HEAP_QUATERNARY);
+}
+
+static void bench_uniform_work(void *item, void *user_data) {
+    volatile uintptr_t sink = (uintptr_t) item;
+    (void) user_data;
+    (void) sink;
+}
+
+static void bench_skewed_work(void *item, void *user_data) {
+    volatile uintptr_t sink = 0;
+
+    if ((uintptr_t) item <= (uintptr_t) user_data) {
+        for (int i = 0; i < BENCH_SKEW_WORK; i++) sink += (uintptr_t) i;
+    }
+}
+
+static long long bench_parallel_for_each(struct basicvector_s **vector, int size, long long ops, long long *done, void (*function)(void *item, void *user_data)) {
+    void *skew_limit = bench_item(size / BENCH_SKEW_FRACTION);
+    long long elapsed = 0;
+    *done = 0;
+
+    while (*done < ops) {
+        long long start = bench_now_ns();
+        basicvector_parallel_for_each(*vector, function, skew_limit);
+        elapsed += bench_now_ns() - start;
+
+        *done += size;
+    }
+
+    return elapsed;
+}
+
+static long long bench_case_parallel_for_each(struct basicvector_s **vector, int size, long long ops, long long *done) {
+    return bench_parallel_for_each(vector, size, ops, done, bench_uniform_work);
+}
+
+static long long bench_case_parallel_for_each_skewed(struct basicvector_s **vector, int size, long long ops, long long *done) {
+    return bench_parallel_for_each(vector, size, ops, done, bench_skewed_work);
+}
+
+struct bench_static_part_s {
+    struct basicvector_s *vector;
+    int begin;
+    int end;
+    void *skew_limit;
+};
+
+static void *bench_static_part_run(void *argument) {
+    struct bench_static_part_s *part = argument;
+
+    for (int i = part->begin; i < part->end; i++) {
+        bench_skewed_work(basicvector_at_unchecked(part->vector, (size_t) i), part->skew_limit);
+    }
+
+    return NULL;
+}
+
+// Baseline for the pool: every thread gets one equal, contiguous part of the vector, no matter how expensive it is
+static long long bench_case_static_for_each_skewed(struct basicvector_s **vector, int size, long long ops, long long *done) {
+    int participants = bench_thread_count + 1;
+    pthread_t threads[participants];
+    struct bench_static_part_s parts[participants];
+    long long elapsed = 0;
+    *done = 0;
+
+    while (*done < ops) {
+        long long start = bench_now_ns();
+
+        for (int t = 0; t < participants; t++) {
+            parts[t] = (struct bench_static_part_s) {
+                .vector = *vector,
+                .begin = (int) ((long long) size * t / participants),
+                .end = (int) ((long long) size * (t + 1) / participants),
+                .skew_limit = bench_item(size / BENCH_SKEW_FRACTION),
+            };
+
+            if (t > 0) pthread_create(&threads[t], NULL, bench_static_part_run, &parts[t]);
+        }
+
+        bench_static_part_run(&parts[0]);
+
+        for (int t = 1; t < participants; t++) {
+            pthread_join(threads[t], NULL);
+        }
+
+        elapsed += bench_now_ns() - start;
+        *done += size;
+    }
+
+    return elapsed;
+}
+
+static struct bench_case_s bench_cases[] = {
+    { "push", bench_case_push },
+    { "get_sequential", bench_case_get_sequential },
+    { "get_random", bench_case_get_random },
+    { "set_dense", bench_case_set_dense },
+    { "set_sparse", bench_case_set_sparse },
+    { "remove_head", bench_case_remove_head },
+    { "remove_middle", bench_case_remove_middle },
+    { "remove_tail", bench_case_remove_tail },
+    { "swap_remove_head", bench_case_swap_remove_head },
+    { "find", bench_case_find },
+    { "find_index", bench_case_find_index },
+    { "find_by_hash_miss", bench_case_find_by_hash_miss },
+    { "heap_pop_push_binary", bench_case_heap_pop_push_binary },
+    { "heap_pop_push_quaternary", bench_case_heap_pop_push_quaternary },
+    { "parallel_for_each", bench_case_parallel_for_each },
+    { "parallel_for_each_skewed", bench_case_parallel_for_each_skewed },
+    { "static_for_each_skewed", bench_case_static_for_each_skewed },
+    { "free", bench_case_free },
+    { "init_free_small", bench_case_init_free_small },
+};
+
+static void bench_print_header() {
+    if (bench_format == BENCH_FORMAT_CSV) {
+        printf("operation,size,ops,total_ns,ns_per_op,ops_per_sec,peak_rss_kb\n");
+    } else {
+        printf("[\n");
+    }
+}
+
+static void bench_print_footer() {
+    if (bench_format == BENCH_FORMAT_JSON) {
+        printf("\n]\n");
+    }
+}
+
+static void bench_print_row(char *operation, int size, long long ops, long long elapsed) {
+    double ns_per_op = ops > 0 ? (double) elapsed / (double) ops : 0.0;
+    double ops_per_sec = elapsed > 0 ? (double) ops * 1e9 / (double) elapsed : 0.0;
+    long peak_rss_kb = bench_peak_rss_kb();
+
+    if (bench_format == BENCH_FORMAT_CSV) {
+        printf("%s,%d,%lld,%lld,%.2f,%.0f,%ld\n", operation, size, ops, elapsed, ns_per_op, ops_per_sec, peak_rss_kb);
+    } else {
+        printf(
+            "%s  {\"operation\": \"%s\", \"size\": %d, \"ops\": %lld, \"total_ns\": %lld, \"ns_per_op\": %.2f, \"ops_per_sec\": %.0f, \"peak_rss_kb\": %ld}",
+            bench_rows_printed == 0 ? "" : ",\n", operation, size, ops, elapsed, ns_per_op, ops_per_sec, peak_rss_kb
+        );
+    }
+
+    bench_rows_printed++;
+    fflush(stdout);
+}
+
+static void bench_run_case(struct bench_case_s *bench_case, struct basicvector_s **vector, int size) {
+    long long batch = 1;
+    long long ops = 0;
+    long long elapsed = 0;
+    long long wall_start = bench_now_ns();
+
+    while (elapsed < BENCH_MIN_TIME_NS && ops < BENCH_MAX_OPS && bench_now_ns() - wall_start < BENCH_MAX_WALL_NS) {
+        long long done;
+        elapsed += bench_case->run(vector, size, batch, &done);
+        ops += done;
+
+        if (batch < BENCH_MAX_OPS / 2) batch *= 2;
+    }
+
+    bench_print_row(bench_case->name, size, ops, elapsed);
+}
+
+int main(int argc, char **argv) {
+    long long max_size = 10000000;
+
+    if (argc > 1) {
+        max_size = atoll(argv[1]);
+
+        if (max_size < 10 || max_size > 2147483647LL) {
+            fprintf(stderr, "max_size must be between 10 and 2147483647\n");
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (argc > 2) {
+        if (strcmp(argv[2], "json") == 0) {
+            bench_format = BENCH_FORMAT_JSON;
+        } else if (strcmp(argv[2], "csv") != 0) {
+            fprintf(stderr, "format must be csv or json\n");
+            return EXIT_FAILURE;
+        }
+    }
+
+    struct basicvector_pool_s *pool;
+    int status = basicvector_pool_create(&pool, -1);
+
+    if (status != BASICVECTOR_SUCCESS) bench_fail("basicvector_pool_create", status);
+
+    basicvector_pool_thread_count(pool, &bench_thread_count);
+    basicvector_pool_set_default(pool);
+
+    bench_print_header();
+
+    double previous_ns_per_push = 0.0;
+
+    for (long long size = 10; size <= max_size; size *= 10) {
+        long long start = bench_now_ns();
+        struct basicvector_s *vector = bench_build((int) size);
+        long long build_ns = bench_now_ns() - start;
+
+        double ns_per_push = (double) build_ns / (double) size;
+
+        for (size_t i = 0; i < sizeof(bench_cases) / sizeof(bench_cases[0]); i++) {
+            bench_run_case(&bench_cases[i], &vector, (int) size);
+        }
+
+        basicvector_free(vector, NULL, NULL);
+
+        // Extrapolate the next build from how push cost grew between the last two sizes
+        double growth = previous_ns_per_push > 0.0 ? ns_per_push / previous_ns_per_push : 1.0;
+        if (growth < 1.0) growth = 1.0;
+
+        double predicted_build_ns = ns_per_push * growth * (double) size * 10.0;
+        previous_ns_per_push = ns_per_push;
+
+        if (size * 10 <= max_size && predicted_build_ns > (double) BENCH_MAX_BUILD_NS) {
+            fprintf(stderr, "skipping sizes above %lld: building the next vector would take ~%.0f s\n", size, predicted_build_ns / 1e9);
+            break;
+        }
+    }
+
+    bench_print_footer();
+
+    basicvector_pool_free(pool);
+
+    return EXIT_SUCCESS;
+}
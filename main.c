@@ -1,6 +1,15 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#ifndef BASICVECTOR_INLINE
+#define BASICVECTOR_INLINE
+#endif
 #include "basicvector.h"
+#include "basicvector_typed.h"
+
+BASICVECTOR_DEFINE(intvector, int)
 
 void assert(bool result, char *message) {
     if (!result) {
@@ -25,6 +34,10 @@ char *status_to_string(int status) {
             return "BASICVECTOR_INVALID_INDEX";
         case BASICVECTOR_INVALID_ARGUMENT:
             return "BASICVECTOR_INVALID_ARGUMENT";
+        case BASICVECTOR_UNSUPPORTED:
+            return "BASICVECTOR_UNSUPPORTED";
+        case BASICVECTOR_OVERFLOW:
+            return "BASICVECTOR_OVERFLOW";
         default:
             return "Unknown status";
     }
@@ -1172,72 +1185,1652 @@ void basicvector_find_index_test_7__test_if_goes_through_every_item_and_passes_c
     pass("basicvector_find_index goes through every item and passes correct arguments");
 }
 
-int main() {
-    test_if_basicvector_init_returns_valid_struct_pointer();
+void test_if_basicvector_memory_usage_reports_storage_and_slack() {
+    struct basicvector_s *vector;
+    struct basicvector_memory_usage_s usage;
+    struct basicvector_memory_usage_s total_before;
+    struct basicvector_memory_usage_s total;
 
-    // basicvector length
-    test_if_basicvector_length_returns_valid_length();
-    test_if_basicvector_length_returns_memory_error_when_passed_null_as_vector();
-    test_if_basicvector_length_returns_invalid_argument_when_passed_null_as_result();
+#ifdef BASICVECTOR_ACCOUNTING
+    expect_status_success(basicvector_memory_usage_total(&total_before));
+#else
+    expect_status(basicvector_memory_usage_total(&total_before), BASICVECTOR_UNSUPPORTED);
+#endif
 
-    // basicvector_push
-    test_if_basicvector_push_pushes_item_at_the_end_of_the_vector();
-    test_if_basicvector_push_returns_memory_error_when_passed_null_as_a_vector();
+    expect_status_success(basicvector_init(&vector));
+    expect_status_success(basicvector_memory_usage(vector, &usage));
+    assert(usage.header_bytes == sizeof(struct basicvector_s), "Expected header to be the vector structure");
+    assert(usage.storage_bytes == 0 && usage.total_bytes == usage.header_bytes, "Expected no storage while items fit inline");
 
-    // basicvector_set
-    test_if_basicvector_set_skips_execution_of_deallocation_function_when_it_is_null_and_there_is_one_item_inside_the_vector();
-    test_if_basicvector_set_skips_execution_of_deallocation_function_when_it_is_null_and_there_are_two_items_inside_the_vector();
-    test_if_basicvector_set_executes_deallocation_function_and_provides_valid_item_and_user_data_to_it_when_there_is_one_item_inside_the_vector();
-    test_if_basicvector_set_executes_deallocation_function_and_provides_valid_item_and_user_data_to_it_when_there_are_two_items_inside_the_vector();
-    test_if_basicvector_set_sets_item_in_the_middle_of_the_vector();
-    test_if_basicvector_set_fills_non_existent_items_with_null_items();
-    test_if_basicvector_set_sets_first_item_when_no_items_are_inside_the_vector();
-    test_if_basicvector_set_sets_first_item_when_there_are_more_than_one_inside_the_vector();
-    test_if_basicvector_set_returns_invalid_index_error_when_index_is_less_than_zero();
-    test_if_basicvector_set_returns_memory_error_when_vector_is_null();
+    for (uintptr_t i = 1; i <= 1000; i++) {
+        expect_status_success(basicvector_push(vector, (void *) i));
+    }
 
-    // basicvector_set
-    test_if_basicvector_get_returns_memory_error_when_vector_is_null();
-    test_if_basicvector_get_returns_invalid_index_error_when_no_items_are_inside();
-    test_if_basicvector_get_returns_item_not_found_error_when_provided_index_equal_to_length();
-    test_if_basicvector_get_returns_proper_value_when_provided_last_item_index_and_there_is_only_one_item_inside_vector();
-    test_if_basicvector_get_returns_proper_value_when_provided_last_item_index();
+    expect_status_success(basicvector_memory_usage(vector, &usage));
+    assert(usage.item_count == 1000, "Expected item count to match length");
+    assert(usage.storage_bytes >= 1000 * sizeof(void *), "Expected storage to hold every item");
+    assert(usage.slack_bytes == usage.storage_bytes - 1000 * sizeof(void *), "Expected slack to be the unused part of storage");
+    assert(usage.total_bytes == usage.header_bytes + usage.storage_bytes + usage.auxiliary_bytes, "Expected total to sum up the parts");
 
-    // find
-    test_if_basicvector_find_returns_memory_error_when_vector_is_null();
-    test_if_basicvector_find_returns_invalid_argument_error_when_result_argument_is_null();
-    test_if_basicvector_find_returns_invalid_argument_error_when_search_function_is_null();
-    test_if_basicvector_find_passes_valid_user_data_pointer_to_search_function();
-    test_if_basicvector_find_returns_item_not_found_and_assigns_null_to_result_when_vector_is_empty();
-    test_if_basicvector_find_returns_item_not_found_and_assigns_null_to_result_when_vector_has_items_and_search_function_does_not_match_any_items();
-    test_if_basicvector_find_returns_success_and_assigns_item_to_result_when_vector_has_at_least_two_items_and_search_function_matches_item();
-    test_if_basicvector_find_returns_success_and_assigns_item_to_result_when_vector_has_one_item_and_search_function_matches_item();
+#ifdef BASICVECTOR_ACCOUNTING
+    expect_status_success(basicvector_memory_usage_total(&total));
+    assert(total.vector_count == total_before.vector_count + 1, "Expected aggregate to count the new vector");
+    assert(total.storage_bytes == total_before.storage_bytes + usage.storage_bytes, "Expected aggregate to include storage of the vector");
+#endif
 
-    test_if_basicvector_remove_returns_memory_error_when_vector_is_null();
-    test_if_basicvector_remove_returns_invalid_index_error_when_provided_index_is_below_zero();
-    test_if_basicvector_remove_skips_execution_of_deallocation_function_when_provided_deallocation_function_is_null_and_vector_has_one_item();
-    test_if_basicvector_remove_skips_execution_of_deallocation_function_when_provided_deallocation_function_is_null_and_vector_has_two_items();
-    test_if_basicvector_remove_executes_deallocation_function_on_every_item_with_valid_user_data_and_item_when_used_on_first_item_of_vector();
-    test_if_basicvector_remove_executes_deallocation_function_on_every_item_with_valid_user_data_and_item_when_used_on_second_item_of_vector();
-    test_if_basicvector_remove_returns_invalid_index_error_when_vector_does_not_have_any_items();
-    test_if_basicvector_remove_returns_invalid_index_error_when_vector_has_one_item_and_provided_index_is_1();
-    test_if_basicvector_remove_returns_invalid_index_error_when_vector_has_two_items_and_provided_index_is_2();
-    test_if_basicvector_remove_removes_first_item();
-    test_if_basicvector_remove_removes_second_item();
-    test_if_basicvector_remove_removes_third_item();
+    size_t storage_bytes = usage.storage_bytes;
 
-    test_if_basicvector_free_returns_memory_error_when_passed_vector_is_null();
-    test_if_basicvector_free_returns_success_when_deallocation_func_is_null();
-    test_if_basicvector_free_executes_deallocation_function_with_valid_user_data_on_every_item();
+    expect_status_success(basicvector_truncate(vector, 100, NULL, NULL));
+    expect_status_success(basicvector_compact(vector));
+    expect_status_success(basicvector_count_non_null(vector, &(size_t) {0}));
+    expect_status_success(basicvector_memory_usage(vector, &usage));
+    assert(usage.storage_bytes < storage_bytes, "Expected compact to reduce storage");
+    assert(usage.auxiliary_bytes > 0, "Expected occupancy bitmap to be reported");
 
-    // basicvector_find_index
-    basicvector_find_index_test_1__test_if_returns_memory_error_when_provided_vector_is_null();
-    basicvector_find_index_test_2__test_if_returns_invalid_argument_when_provided_search_function_is_null();
-    basicvector_find_index_test_3__test_if_returns_invalid_argument_when_provided_result_ptr_is_null();
-    basicvector_find_index_test_4__test_if_returns_item_not_found_error_when_no_items_are_inside();
-    basicvector_find_index_test_5__test_if_returns_item_not_found_error_when_search_function_returns_false_on_every_item();
-    basicvector_find_index_test_6__test_if_returns_success_and_assigns_index_to_result_when_search_function_returns_true_on_some_item();
-    basicvector_find_index_test_7__test_if_goes_through_every_item_and_passes_correct_arguments();
+    expect_status(basicvector_memory_usage(NULL, &usage), BASICVECTOR_MEMORY_ERROR);
+    expect_status(basicvector_memory_usage(vector, NULL), BASICVECTOR_INVALID_ARGUMENT);
+    expect_status(basicvector_memory_usage_total(NULL), BASICVECTOR_INVALID_ARGUMENT);
+
+    expect_status_success(basicvector_free(vector, NULL, NULL));
+
+#ifdef BASICVECTOR_ACCOUNTING
+    expect_status_success(basicvector_memory_usage_total(&total));
+    assert(total.vector_count == total_before.vector_count && total.storage_bytes == total_before.storage_bytes,
+        "Expected aggregate to drop freed vector");
+#else
+    (void) total;
+#endif
+
+    pass("basicvector_memory_usage reports storage and slack");
+}
+
+void test_if_basicvector_stats_returns_memory_error_when_vector_is_null() {
+    struct basicvector_stats_s stats;
+
+    expect_status(basicvector_stats(NULL, &stats), BASICVECTOR_MEMORY_ERROR);
+
+    pass("basicvector_stats returns memory error when vector is null");
+}
+
+void test_if_basicvector_stats_returns_invalid_argument_when_result_is_null() {
+    struct basicvector_s *vector;
+
+    expect_status_success(basicvector_init(&vector));
+
+    expect_status(basicvector_stats(vector, NULL), BASICVECTOR_INVALID_ARGUMENT);
+
+    expect_status_success(basicvector_free(vector, NULL, NULL));
+
+    pass("basicvector_stats returns invalid argument when result is null");
+}
+
+bool basicvector_stats_test__search_function(void *item, void *user_data) {
+    return item == user_data;
+}
+
+void test_if_basicvector_stats_counts_calls_allocations_and_walked_entries() {
+    struct basicvector_s *vector;
+    struct basicvector_stats_s stats;
+    int items[3] = { 1, 2, 3 };
+    void *result;
+
+    expect_status_success(basicvector_init(&vector));
+
+#ifdef BASICVECTOR_STATS
+    for (int i = 0; i < 3; i++) {
+        expect_status_success(basicvector_push(vector, &items[i]));
+    }
+
+    expect_status_success(basicvector_get(vector, 2, &result));
+    expect_status_success(basicvector_find(vector, &result, basicvector_stats_test__search_function, &items[1]));
+    expect_status_success(basicvector_set(vector, 4, &items[0], NULL, NULL));
+    expect_status_success(basicvector_remove(vector, 1, NULL, NULL));
+
+    expect_status_success(basicvector_stats(vector, &stats));
+
+    assert(stats.push_calls == 3, "Expected 3 push calls");
+    assert(stats.push_entries_walked == 0, "Expected push not to walk any entries");
+    assert(stats.get_calls == 1 && stats.get_entries_walked == 0, "Expected 1 get call walking no entries");
+    assert(stats.find_calls == 1 && stats.find_entries_walked == 2, "Expected 1 find call walking 2 entries");
+    assert(stats.set_calls == 1 && stats.set_entries_walked == 1, "Expected 1 set call filling 1 entry");
+    assert(stats.remove_calls == 1 && stats.remove_entries_walked == 3, "Expected 1 remove call moving 3 entries");
+#if BASICVECTOR_SMALL_CAPACITY >= 5
+    assert(stats.mallocs == 1, "Expected 1 malloc (vector only, items fit into inline storage)");
+    assert(stats.frees == 0, "Expected no frees while items fit into inline storage");
+#endif
+    assert(stats.peak_length == 5, "Expected peak length to be 5");
+
+    // Spilling to the heap allocates, growing the heap storage reallocates and compacting back into inline storage frees
+    expect_status_success(basicvector_truncate(vector, 0, NULL, NULL));
+    expect_status_success(basicvector_compact(vector));
+    expect_status_success(basicvector_stats(vector, &stats));
+
+    unsigned long long mallocs = stats.mallocs;
+    unsigned long long frees = stats.frees;
+
+    while (vector->length <= BASICVECTOR_SMALL_CAPACITY) {
+        expect_status_success(basicvector_push(vector, &items[0]));
+    }
+
+    size_t spilled_capacity = vector->capacity;
+
+    while (vector->capacity == spilled_capacity) {
+        expect_status_success(basicvector_push(vector, &items[0]));
+    }
+
+    expect_status_success(basicvector_truncate(vector, 0, NULL, NULL));
+    expect_status_success(basicvector_compact(vector));
+    expect_status_success(basicvector_stats(vector, &stats));
+
+    assert(stats.mallocs == mallocs + 2, "Expected 2 mallocs (spill and growth)");
+    assert(stats.frees == frees + 2, "Expected 2 frees (storage given up by growth and by compacting)");
+#else
+    (void) items;
+    (void) result;
+
+    expect_status(basicvector_stats(vector, &stats), BASICVECTOR_UNSUPPORTED);
+#endif
+
+    expect_status_success(basicvector_free(vector, NULL, NULL));
+
+    pass("basicvector_stats counts calls, allocations and walked entries");
+}
+
+void test_if_basicvector_unchecked_accessors_match_checked_ones() {
+    struct basicvector_s *vector;
+    int items[5] = { 1, 2, 3, 4, 5 };
+
+    expect_status_success(basicvector_init(&vector));
+
+    assert(basicvector_len_unchecked(vector) == 0, "Expected unchecked length of empty vector to be 0");
+
+    for (int i = 0; i < 5; i++) {
+        expect_status_success(basicvector_push(vector, &items[i]));
+    }
+
+    expect_status_success(basicvector_remove(vector, 1, NULL, NULL));
+
+    assert(basicvector_len_unchecked(vector) == 4, "Expected unchecked length to be 4");
+
+    for (int i = 0; i < 4; i++) {
+        void *item;
+        expect_status_success(basicvector_get(vector, i, &item));
+        assert(basicvector_at_unchecked(vector, i) == item, "Expected unchecked item to be equal to checked one");
+    }
+
+    expect_status_success(basicvector_free(vector, NULL, NULL));
+
+    pass("basicvector unchecked accessors match checked ones");
+}
+
+bool intvector_test__search_function(const int *item, void *user_data) {
+    return *item == *(int *) user_data;
+}
+
+void test_if_typed_vector_stores_items_by_value() {
+    struct intvector_s *vector = NULL;
+    int item = 0;
+    int index = -1;
+    int length = 0;
+
+    expect_status_success(intvector_init(&vector));
+
+    for (int i = 0; i < 10; i++) {
+        expect_status_success(intvector_push(vector, i * 10));
+    }
+
+    expect_status_success(intvector_remove(vector, 0));
+    expect_status_success(intvector_set(vector, 11, 7));
+
+    expect_status_success(intvector_length(vector, &length));
+    assert(length == 12, "Expected typed vector length to be 12");
+
+    expect_status_success(intvector_get(vector, 0, &item));
+    assert(item == 10, "Expected first item to be 10");
+
+    expect_status_success(intvector_get(vector, 9, &item));
+    assert(item == 0, "Expected gap item to be zeroed");
+
+    expect_status_success(intvector_get(vector, 11, &item));
+    assert(item == 7, "Expected last item to be 7");
+
+    int wanted = 50;
+    expect_status_success(intvector_find_index(vector, &index, intvector_test__search_function, &wanted));
+    assert(index == 4, "Expected index of 50 to be 4");
+
+    wanted = 55;
+    item = 7;
+    expect_status(intvector_find(vector, &item, intvector_test__search_function, &wanted), BASICVECTOR_ITEM_NOT_FOUND);
+    assert(item == 0, "Expected find of absent item to zero the result");
+
+    item = 7;
+    expect_status(intvector_get(vector, 12, &item), BASICVECTOR_ITEM_NOT_FOUND);
+    assert(item == 0, "Expected get past the end to zero the result");
+    expect_status(intvector_set(vector, -1, 0), BASICVECTOR_INVALID_INDEX);
+    expect_status(intvector_remove(vector, 12), BASICVECTOR_INVALID_INDEX);
+    expect_status(intvector_push(NULL, 0), BASICVECTOR_MEMORY_ERROR);
+
+    expect_status_success(intvector_free(vector));
+
+    pass("typed vector stores items by value");
+}
+
+void test_if_basicvector_init_inplace_stores_small_vectors_without_allocations_and_spills_to_heap() {
+    struct basicvector_s vector;
+    int items[BASICVECTOR_SMALL_CAPACITY + 1];
+
+    expect_status_success(basicvector_init_inplace(&vector));
+
+    for (int i = 0; i < BASICVECTOR_SMALL_CAPACITY; i++) {
+        expect_status_success(basicvector_push(&vector, &items[i]));
+    }
+
+    assert(vector.items == vector.small_items, "Expected items to be stored inline");
+
+#ifdef BASICVECTOR_STATS
+    struct basicvector_stats_s stats;
+    expect_status_success(basicvector_stats(&vector, &stats));
+    assert(stats.mallocs == 0, "Expected no mallocs for small inplace vector");
+#endif
+
+    expect_status_success(basicvector_push(&vector, &items[BASICVECTOR_SMALL_CAPACITY]));
+
+    assert(vector.items != vector.small_items, "Expected items to spill to heap storage");
+    expect_length_to_be(&vector, BASICVECTOR_SMALL_CAPACITY + 1);
+
+    for (int i = 0; i <= BASICVECTOR_SMALL_CAPACITY; i++) {
+        expect_item_to_be(&vector, i, &items[i]);
+    }
+
+    expect_status_success(basicvector_free_inplace(&vector, NULL, NULL));
+    expect_length_to_be(&vector, 0);
+
+    expect_status(basicvector_init_inplace(NULL), BASICVECTOR_MEMORY_ERROR);
+    expect_status(basicvector_free_inplace(NULL, NULL, NULL), BASICVECTOR_MEMORY_ERROR);
+
+    pass("basicvector_init_inplace stores small vectors without allocations and spills to heap");
+}
+
+bool basicvector_64bit_test__search_function(void *item, void *user_data) {
+    return item == user_data;
+}
+
+// Long enough to spill out of inline storage whatever BASICVECTOR_SMALL_CAPACITY is
+#define ARRAY_TEST_LENGTH (BASICVECTOR_SMALL_CAPACITY + 100)
+
+void test_if_basicvector_array_conversions_keep_items_in_order() {
+    struct basicvector_s *vector;
+    void *items[ARRAY_TEST_LENGTH];
+    void *out[ARRAY_TEST_LENGTH];
+    void **data;
+
+    for (uintptr_t i = 0; i < ARRAY_TEST_LENGTH; i++) {
+        items[i] = (void *) (i + 1);
+    }
+
+    expect_status_success(basicvector_from_array(&vector, items, BASICVECTOR_SMALL_CAPACITY));
+    assert(vector->items == vector->small_items, "Expected items fitting into inline storage to be stored inline");
+    expect_length_to_be(vector, BASICVECTOR_SMALL_CAPACITY);
+    expect_status_success(basicvector_free(vector, NULL, NULL));
+
+    expect_status_success(basicvector_from_array(&vector, items, ARRAY_TEST_LENGTH));
+    assert(vector->capacity == ARRAY_TEST_LENGTH, "Expected storage to be allocated for exactly the copied items");
+    expect_length_to_be(vector, ARRAY_TEST_LENGTH);
+    expect_item_to_be(vector, ARRAY_TEST_LENGTH - 1, (int *) ARRAY_TEST_LENGTH);
+
+    expect_status(basicvector_to_array(vector, out, ARRAY_TEST_LENGTH - 1), BASICVECTOR_OVERFLOW);
+    expect_status_success(basicvector_to_array(vector, out, ARRAY_TEST_LENGTH));
+    assert(memcmp(out, items, sizeof(items)) == 0, "Expected to_array to copy every item in order");
+
+    // Tombstones are dropped before storage is exposed
+    expect_status_success(basicvector_remove_deferred(vector, 0, NULL, NULL));
+    expect_status_success(basicvector_data(vector, &data));
+    assert(data[0] == (void *) 2 && data[ARRAY_TEST_LENGTH - 2] == (void *) ARRAY_TEST_LENGTH, "Expected data to expose items in order");
+    expect_status_success(basicvector_free(vector, NULL, NULL));
+
+    size_t adopted_count = ARRAY_TEST_LENGTH / 2;
+    void **buffer = malloc(sizeof(void *) * (adopted_count + 1));
+
+    for (uintptr_t i = 0; i < adopted_count; i++) {
+        buffer[i] = (void *) (i + 1);
+    }
+
+    expect_status_success(basicvector_from_array_adopt(&vector, buffer, adopted_count, adopted_count + 1));
+    assert(vector->items == buffer, "Expected adopted array to become the storage");
+
+    for (uintptr_t i = adopted_count + 1; i <= ARRAY_TEST_LENGTH; i++) {
+        expect_status_success(basicvector_push(vector, (void *) i));
+    }
+
+    expect_status_success(basicvector_to_array(vector, out, ARRAY_TEST_LENGTH));
+    assert(memcmp(out, items, sizeof(items)) == 0, "Expected adopted storage to grow like any other");
+    expect_status_success(basicvector_free(vector, NULL, NULL));
+
+    // Arrays in the huge page range are adopted as well, they stay storage from malloc when growing and when freed
+    size_t large_count = 2 * 1024 * 1024 / sizeof(void *) + 1;
+    buffer = calloc(large_count, sizeof(void *));
+    buffer[large_count - 1] = (void *) 1;
+
+    expect_status_success(basicvector_from_array_adopt(&vector, buffer, large_count, large_count));
+    expect_status_success(basicvector_data(vector, &data));
+    assert(data == buffer, "Expected large adopted array to become the storage without copying");
+    assert(data[large_count - 1] == (void *) 1, "Expected every adopted item to be kept");
+    expect_status_success(basicvector_push(vector, (void *) 2));
+    expect_item_to_be(vector, large_count - 1, (int *) 1);
+    expect_item_to_be(vector, large_count, (int *) 2);
+    expect_status_success(basicvector_truncate(vector, 1, NULL, NULL));
+    expect_status_success(basicvector_compact(vector));
+    expect_length_to_be(vector, 1);
+    expect_status_success(basicvector_free(vector, NULL, NULL));
+
+    expect_status(basicvector_from_array(&vector, NULL, 1), BASICVECTOR_INVALID_ARGUMENT);
+    expect_status(basicvector_from_array_adopt(&vector, items, 10, 5), BASICVECTOR_INVALID_ARGUMENT);
+    expect_status(basicvector_to_array(NULL, out, 0), BASICVECTOR_MEMORY_ERROR);
+    expect_status(basicvector_data(NULL, &data), BASICVECTOR_MEMORY_ERROR);
+
+    pass("basicvector array conversions keep items in order");
+}
+
+void test_if_basicvector_64bit_api_matches_int_api() {
+    struct basicvector_s *vector;
+    int items[3] = { 1, 2, 3 };
+    void *item;
+    size_t length;
+    size_t index;
+
+    expect_status_success(basicvector_init(&vector));
+
+    expect_status_success(basicvector_set64(vector, 2, &items[2], NULL, NULL));
+    expect_status_success(basicvector_set64(vector, 0, &items[0], NULL, NULL));
+    expect_status_success(basicvector_set64(vector, 1, &items[1], NULL, NULL));
+
+    expect_status_success(basicvector_length64(vector, &length));
+    assert(length == 3, "Expected 64-bit length to be 3");
+
+    for (size_t i = 0; i < 3; i++) {
+        expect_status_success(basicvector_get64(vector, i, &item));
+        assert(item == &items[i], "Expected 64-bit get to return item set under given index");
+    }
+
+    expect_status_success(basicvector_find_index64(vector, &index, basicvector_64bit_test__search_function, &items[2]));
+    assert(index == 2, "Expected 64-bit find index to be 2");
+
+    expect_status_success(basicvector_remove64(vector, 0, NULL, NULL));
+    expect_item_to_be(vector, 0, &items[1]);
+
+    expect_status(basicvector_get64(vector, 2, &item), BASICVECTOR_ITEM_NOT_FOUND);
+    expect_status(basicvector_remove64(vector, 2, NULL, NULL), BASICVECTOR_INVALID_INDEX);
+    expect_status(basicvector_length64(NULL, &length), BASICVECTOR_MEMORY_ERROR);
+    expect_status(basicvector_length64(vector, NULL), BASICVECTOR_INVALID_ARGUMENT);
+    expect_status(basicvector_get(vector, -1, &item), BASICVECTOR_ITEM_NOT_FOUND);
+    assert(item == NULL, "Expected get with negative index to assign null to result");
+
+    expect_status_success(basicvector_free(vector, NULL, NULL));
+
+    pass("basicvector 64-bit api matches int api");
+}
+
+#define PARALLEL_TEST_LENGTH 100000
+
+void parallel_test__increment(void *item, void *user_data) {
+    (void) user_data;
+    (*(int *) item)++;
+}
+
+void *parallel_test__map(void *item, void *user_data) {
+    return (void *) ((uintptr_t) item * (uintptr_t) user_data);
+}
+
+void *parallel_test__sum(void *accumulator, void *item, void *user_data) {
+    (void) user_data;
+    return (void *) ((uintptr_t) accumulator + (uintptr_t) item);
+}
+
+void *parallel_test__count_odd(void *accumulator, void *item, void *user_data) {
+    (void) user_data;
+    return (void *) ((uintptr_t) accumulator + (uintptr_t) item % 2);
+}
+
+void test_if_basicvector_parallel_for_each_visits_every_item_once() {
+    struct basicvector_s *vector;
+    int *counters = calloc(PARALLEL_TEST_LENGTH, sizeof(int));
+
+    expect_status_success(basicvector_init(&vector));
+
+    for (int i = 0; i < PARALLEL_TEST_LENGTH; i++) {
+        expect_status_success(basicvector_push(vector, &counters[i]));
+    }
+
+    expect_status_success(basicvector_parallel_for_each(vector, parallel_test__increment, NULL));
+    expect_status_success(basicvector_for_each(vector, parallel_test__increment, NULL));
+
+    for (int i = 0; i < PARALLEL_TEST_LENGTH; i++) {
+        assert(counters[i] == 2, "Expected every item to be visited once by each for_each");
+    }
+
+    expect_status(basicvector_parallel_for_each(NULL, parallel_test__increment, NULL), BASICVECTOR_MEMORY_ERROR);
+    expect_status(basicvector_parallel_for_each(vector, NULL, NULL), BASICVECTOR_INVALID_ARGUMENT);
+
+    expect_status_success(basicvector_free(vector, NULL, NULL));
+    free(counters);
+
+    pass("basicvector_parallel_for_each visits every item once");
+}
+
+void test_if_basicvector_map_into_and_reduce_parallel_compute_valid_results() {
+    struct basicvector_s *vector;
+    struct basicvector_s *mapped;
+    void *sum;
+
+    expect_status_success(basicvector_init(&vector));
+
+    expect_status_success(basicvector_reduce_parallel(vector, &sum, (void *) 7, parallel_test__sum, parallel_test__sum, NULL));
+    assert(sum == (void *) 7, "Expected reduce of empty vector to return initial value");
+
+    for (uintptr_t i = 1; i <= PARALLEL_TEST_LENGTH; i++) {
+        expect_status_success(basicvector_push(vector, (void *) i));
+    }
+
+    expect_status_success(basicvector_map_into(vector, &mapped, parallel_test__map, (void *) 3));
+    expect_length_to_be(mapped, PARALLEL_TEST_LENGTH);
+
+    for (int i = 0; i < PARALLEL_TEST_LENGTH; i++) {
+        expect_item_to_be(mapped, i, (int *) ((uintptr_t) (i + 1) * 3));
+    }
+
+    expect_status_success(basicvector_reduce_parallel(vector, &sum, NULL, parallel_test__sum, parallel_test__sum, NULL));
+
+    uintptr_t expected_sum = (uintptr_t) PARALLEL_TEST_LENGTH * (PARALLEL_TEST_LENGTH + 1) / 2;
+    assert((uintptr_t) sum == expected_sum, "Expected reduce to sum all items");
+
+    // The accumulator is a count rather than an item, partial counts are merged by adding them up
+    void *odd_count;
+    expect_status_success(basicvector_reduce_parallel(vector, &odd_count, NULL, parallel_test__count_odd, parallel_test__sum, NULL));
+    assert((uintptr_t) odd_count == (PARALLEL_TEST_LENGTH + 1) / 2, "Expected reduce to count odd items");
+
+    expect_status(basicvector_map_into(vector, NULL, parallel_test__map, NULL), BASICVECTOR_INVALID_ARGUMENT);
+    expect_status(basicvector_reduce_parallel(vector, &sum, NULL, NULL, parallel_test__sum, NULL), BASICVECTOR_INVALID_ARGUMENT);
+    expect_status(basicvector_reduce_parallel(vector, &sum, NULL, parallel_test__sum, NULL, NULL), BASICVECTOR_INVALID_ARGUMENT);
+
+    expect_status_success(basicvector_free(mapped, NULL, NULL));
+    expect_status_success(basicvector_free(vector, NULL, NULL));
+
+    pass("basicvector_map_into and basicvector_reduce_parallel compute valid results");
+}
+
+bool parallel_test__has_key_500_from_position(void *item, void *user_data) {
+    return ((uintptr_t) item >> 20) == 500 && ((uintptr_t) item & 0xfffff) >= (uintptr_t) user_data;
+}
+
+int parallel_test__compare_keys(void *left, void *right, void *user_data) {
+    (void) user_data;
+    uintptr_t left_key = (uintptr_t) left >> 20;
+    uintptr_t right_key = (uintptr_t) right >> 20;
+
+    return left_key < right_key ? -1 : left_key > right_key;
+}
+
+void parallel_test__skewed_increment(void *item, void *user_data) {
+    volatile uintptr_t work = 0;
+
+    // Only the first items are expensive, so a static split would leave most threads idle
+    if ((int *) item - (int *) user_data < PARALLEL_TEST_LENGTH / 16) {
+        for (int i = 0; i < 2000; i++) work += (uintptr_t) i;
+    }
+
+    (*(int *) item)++;
+}
+
+void test_if_basicvector_pool_runs_parallel_operations_on_custom_pool() {
+    struct basicvector_pool_s *pool;
+    struct basicvector_s *vector;
+    int *counters = calloc(PARALLEL_TEST_LENGTH, sizeof(int));
+    int thread_count;
+    size_t index;
+
+    expect_status(basicvector_pool_create(NULL, 3), BASICVECTOR_INVALID_ARGUMENT);
+    expect_status_success(basicvector_pool_create(&pool, 3));
+    expect_status_success(basicvector_pool_thread_count(pool, &thread_count));
+    assert(thread_count == 3, "Expected pool to start 3 workers");
+    expect_status_success(basicvector_pool_set_default(pool));
+
+    expect_status_success(basicvector_init(&vector));
+
+    for (int i = 0; i < PARALLEL_TEST_LENGTH; i++) {
+        expect_status_success(basicvector_push(vector, &counters[i]));
+    }
+
+    expect_status_success(basicvector_parallel_for_each(vector, parallel_test__skewed_increment, counters));
+
+    for (int i = 0; i < PARALLEL_TEST_LENGTH; i++) {
+        assert(counters[i] == 1, "Expected every item to be visited once on custom pool");
+    }
+
+    expect_status_success(basicvector_free(vector, NULL, NULL));
+    expect_status_success(basicvector_init(&vector));
+
+    // Keys repeat, the lower 20 bits keep the original position to check stability
+    for (uintptr_t i = 0; i < PARALLEL_TEST_LENGTH; i++) {
+        expect_status_success(basicvector_push(vector, (void *) ((((i * 7919) % 1000) << 20) | i)));
+    }
+
+    expect_status_success(basicvector_parallel_find_index(vector, &index, parallel_test__has_key_500_from_position, (void *) 60000));
+    assert(index == 60500, "Expected parallel find to return the first matching index");
+    expect_status(basicvector_parallel_find_index(vector, &index, parallel_test__has_key_500_from_position, (void *) PARALLEL_TEST_LENGTH), BASICVECTOR_ITEM_NOT_FOUND);
+
+    expect_status_success(basicvector_sort(vector, parallel_test__compare_keys, NULL));
+    expect_length_to_be(vector, PARALLEL_TEST_LENGTH);
+
+    for (size_t i = 1; i < PARALLEL_TEST_LENGTH; i++) {
+        uintptr_t previous = (uintptr_t) basicvector_at_unchecked(vector, i - 1);
+        uintptr_t current = (uintptr_t) basicvector_at_unchecked(vector, i);
+
+        assert((previous >> 20) < (current >> 20) || ((previous >> 20) == (current >> 20) && (previous & 0xfffff) < (current & 0xfffff)), "Expected sort to order items by key and keep order of equal keys");
+    }
+
+    expect_status(basicvector_sort(vector, NULL, NULL), BASICVECTOR_INVALID_ARGUMENT);
+    expect_status(basicvector_parallel_find_index(vector, NULL, parallel_test__has_key_500_from_position, NULL), BASICVECTOR_INVALID_ARGUMENT);
+
+    expect_status_success(basicvector_free(vector, NULL, NULL));
+    expect_status_success(basicvector_pool_free(pool));
+    expect_status(basicvector_pool_free(NULL), BASICVECTOR_MEMORY_ERROR);
+    free(counters);
+
+    pass("basicvector pool runs parallel operations on custom pool");
+}
+
+void parallel_test__nested_reduce(void *item, void *user_data) {
+    struct basicvector_s *inner = user_data;
+    uintptr_t *slot = item;
+
+    // Every 10000th item starts a parallel operation of its own from inside the callback
+    if (*slot % 10000 == 0) {
+        void *sum = NULL;
+
+        if (basicvector_reduce_parallel(inner, &sum, NULL, parallel_test__sum, parallel_test__sum, NULL) == BASICVECTOR_SUCCESS) {
+            *slot = (uintptr_t) sum;
+        }
+    }
+}
+
+void test_if_basicvector_parallel_operations_can_be_nested() {
+    struct basicvector_pool_s *pool;
+    struct basicvector_s *outer;
+    struct basicvector_s *inner;
+    uintptr_t *slots = malloc(PARALLEL_TEST_LENGTH * sizeof(uintptr_t));
+
+    expect_status_success(basicvector_pool_create(&pool, 3));
+    expect_status_success(basicvector_pool_set_default(pool));
+
+    expect_status_success(basicvector_init(&outer));
+    expect_status_success(basicvector_init(&inner));
+
+    for (uintptr_t i = 0; i < PARALLEL_TEST_LENGTH; i++) {
+        slots[i] = i;
+        expect_status_success(basicvector_push(outer, &slots[i]));
+        expect_status_success(basicvector_push(inner, (void *) (i + 1)));
+    }
+
+    expect_status_success(basicvector_parallel_for_each(outer, parallel_test__nested_reduce, inner));
+
+    for (uintptr_t i = 0; i < PARALLEL_TEST_LENGTH; i++) {
+        uintptr_t expected = i % 10000 == 0 ? (uintptr_t) PARALLEL_TEST_LENGTH * (PARALLEL_TEST_LENGTH + 1) / 2 : i;
+
+        assert(slots[i] == expected, "Expected nested reduce to finish with the sum of inner items");
+    }
+
+    expect_status_success(basicvector_free(outer, NULL, NULL));
+    expect_status_success(basicvector_free(inner, NULL, NULL));
+    expect_status_success(basicvector_pool_free(pool));
+    free(slots);
+
+    pass("basicvector parallel operations can be nested");
+}
+
+struct batch_test__log_s {
+    int calls;
+    int items;
+    uintptr_t sum;
+};
+
+void batch_test__dealloc_batch(void **items, int count, void *user_data) {
+    struct batch_test__log_s *log = user_data;
+
+    log->calls++;
+    log->items += count;
+
+    for (int i = 0; i < count; i++) {
+        log->sum += (uintptr_t) items[i];
+    }
+}
+
+void batch_test__atomic_dealloc(void *item, void *user_data) {
+    atomic_fetch_add((_Atomic uintptr_t *) user_data, (uintptr_t) item);
+}
+
+void test_if_basicvector_batched_operations_pass_items_in_single_batches() {
+    struct basicvector_s *vector;
+    struct batch_test__log_s log = {0};
+    void *replacements[] = {(void *) 100, (void *) 200, (void *) 300};
+
+    expect_status_success(basicvector_init(&vector));
+
+    for (uintptr_t i = 1; i <= 10; i++) {
+        expect_status_success(basicvector_push(vector, (void *) i));
+    }
+
+    expect_status_success(basicvector_set(vector, 3, NULL, NULL, NULL));
+
+    // Overwrites items 2, 3 and NULL, the null item is not passed to the callback
+    expect_status_success(basicvector_set_batched(vector, 1, replacements, 3, batch_test__dealloc_batch, &log));
+    assert(log.calls == 1 && log.items == 2 && log.sum == 5, "Expected set_batched to pass non-null overwritten items in one batch");
+    expect_item_to_be(vector, 1, (int *) 100);
+    expect_item_to_be(vector, 3, (int *) 300);
+    expect_item_to_be(vector, 4, (int *) 5);
+
+    // Extends the vector past its end with a null gap
+    expect_status_success(basicvector_set_batched(vector, 11, replacements, 2, batch_test__dealloc_batch, &log));
+    expect_length_to_be(vector, 13);
+    expect_item_to_be(vector, 10, NULL);
+    expect_item_to_be(vector, 12, (int *) 200);
+    assert(log.calls == 1, "Expected no callback when nothing is overwritten");
+
+    log = (struct batch_test__log_s) {0};
+    expect_status_success(basicvector_remove_batched(vector, 4, 5, batch_test__dealloc_batch, &log));
+    assert(log.calls == 1 && log.items == 5 && log.sum == 5 + 6 + 7 + 8 + 9, "Expected remove_batched to pass removed items in one batch");
+    expect_length_to_be(vector, 8);
+    expect_item_to_be(vector, 4, (int *) 10);
+
+    expect_status(basicvector_remove_batched(vector, 4, 5, NULL, NULL), BASICVECTOR_INVALID_INDEX);
+    expect_status(basicvector_set_batched(vector, 0, NULL, 1, NULL, NULL), BASICVECTOR_INVALID_ARGUMENT);
+    expect_status(basicvector_remove_batched(NULL, 0, 1, NULL, NULL), BASICVECTOR_MEMORY_ERROR);
+
+    log = (struct batch_test__log_s) {0};
+    expect_status_success(basicvector_free_batched(vector, batch_test__dealloc_batch, &log));
+    assert(log.calls == 1 && log.items == 8, "Expected free_batched to pass every item in one batch");
+    expect_status(basicvector_free_batched(NULL, NULL, NULL), BASICVECTOR_MEMORY_ERROR);
+
+    pass("basicvector batched operations pass items in single batches");
+}
+
+void test_if_basicvector_free_parallel_deallocates_every_item() {
+    struct basicvector_pool_s *pool;
+    struct basicvector_s *vector;
+    _Atomic uintptr_t sum = 0;
+
+    expect_status_success(basicvector_pool_create(&pool, 3));
+    expect_status_success(basicvector_pool_set_default(pool));
+    expect_status_success(basicvector_init(&vector));
+
+    for (uintptr_t i = 1; i <= PARALLEL_TEST_LENGTH; i++) {
+        expect_status_success(basicvector_push(vector, (void *) i));
+    }
+
+    expect_status_success(basicvector_free_parallel(vector, batch_test__atomic_dealloc, &sum));
+    assert(sum == (uintptr_t) PARALLEL_TEST_LENGTH * (PARALLEL_TEST_LENGTH + 1) / 2, "Expected every item to be deallocated once");
+    expect_status(basicvector_free_parallel(NULL, NULL, NULL), BASICVECTOR_MEMORY_ERROR);
+    expect_status_success(basicvector_pool_free(pool));
+
+    pass("basicvector_free_parallel deallocates every item");
+}
+
+#define SHARDED_TEST_THREADS 4
+#define SHARDED_TEST_ITEMS_PER_THREAD 10000
+
+struct sharded_test__writer_s {
+    struct basicvector_sharded_s *sharded;
+    uintptr_t first_item;
+    int failures;
+};
+
+void *sharded_test__write(void *argument) {
+    struct sharded_test__writer_s *writer = argument;
+
+    for (uintptr_t i = 0; i < SHARDED_TEST_ITEMS_PER_THREAD; i++) {
+        if (basicvector_sharded_push(writer->sharded, (void *) (writer->first_item + i)) != BASICVECTOR_SUCCESS) {
+            writer->failures++;
+        }
+    }
+
+    return NULL;
+}
+
+void test_if_basicvector_sharded_collects_items_of_all_threads() {
+    struct basicvector_sharded_s *sharded;
+    struct basicvector_s *vector;
+    pthread_t threads[SHARDED_TEST_THREADS];
+    struct sharded_test__writer_s writers[SHARDED_TEST_THREADS];
+    _Atomic uintptr_t sum = 0;
+    size_t length;
+    uintptr_t total = SHARDED_TEST_THREADS * SHARDED_TEST_ITEMS_PER_THREAD;
+
+    expect_status_success(basicvector_sharded_init(&sharded, SHARDED_TEST_THREADS));
+
+    for (int i = 0; i < SHARDED_TEST_THREADS; i++) {
+        writers[i] = (struct sharded_test__writer_s) { sharded, 1 + (uintptr_t) i * SHARDED_TEST_ITEMS_PER_THREAD, 0 };
+        pthread_create(&threads[i], NULL, sharded_test__write, &writers[i]);
+    }
+
+    for (int i = 0; i < SHARDED_TEST_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+        assert(writers[i].failures == 0, "Expected every sharded push to succeed");
+    }
+
+    expect_status_success(basicvector_sharded_length(sharded, &length));
+    assert(length == total, "Expected sharded length to count items of all shards");
+
+    expect_status_success(basicvector_sharded_for_each(sharded, batch_test__atomic_dealloc, &sum));
+    assert(sum == total * (total + 1) / 2, "Expected sharded for_each to visit every item once");
+
+    expect_status_success(basicvector_init(&vector));
+    expect_status_success(basicvector_sharded_collect(sharded, vector));
+    expect_length_to_be(vector, (int) total);
+    expect_status_success(basicvector_sharded_length(sharded, &length));
+    assert(length == 0, "Expected collect to leave shards empty");
+
+    // Items of every thread keep their order after collecting
+    uintptr_t next_items[SHARDED_TEST_THREADS];
+
+    for (int i = 0; i < SHARDED_TEST_THREADS; i++) {
+        next_items[i] = writers[i].first_item;
+    }
+
+    for (int i = 0; i < (int) total; i++) {
+        void *item;
+        expect_status_success(basicvector_get(vector, i, &item));
+
+        int writer = (int) (((uintptr_t) item - 1) / SHARDED_TEST_ITEMS_PER_THREAD);
+        assert(next_items[writer] == (uintptr_t) item, "Expected items of one thread to stay in push order");
+        next_items[writer]++;
+    }
+
+    expect_status(basicvector_sharded_push(NULL, NULL), BASICVECTOR_MEMORY_ERROR);
+    expect_status(basicvector_sharded_length(sharded, NULL), BASICVECTOR_INVALID_ARGUMENT);
+    expect_status(basicvector_sharded_collect(sharded, NULL), BASICVECTOR_MEMORY_ERROR);
+
+    expect_status_success(basicvector_free(vector, NULL, NULL));
+    expect_status_success(basicvector_sharded_free(sharded, NULL, NULL));
+
+    pass("basicvector sharded vector collects items of all threads");
+}
+
+void *header_cache_test__churn(void *argument) {
+    int *failures = argument;
+
+    for (int round = 0; round < 100; round++) {
+        struct basicvector_s *vectors[40];
+
+        for (int i = 0; i < 40; i++) {
+            if (basicvector_init(&vectors[i]) != BASICVECTOR_SUCCESS) (*failures)++;
+            if (basicvector_push(vectors[i], vectors[i]) != BASICVECTOR_SUCCESS) (*failures)++;
+        }
+
+        for (int i = 0; i < 40; i++) {
+            basicvector_free(vectors[i], NULL, NULL);
+        }
+    }
+
+    return NULL;
+}
+
+void test_if_basicvector_header_cache_reuses_freed_vectors() {
+    struct basicvector_s *first;
+    struct basicvector_s *second;
+    pthread_t threads[3];
+    int failures[3] = {0};
+
+    expect_status_success(basicvector_init(&first));
+    expect_status_success(basicvector_push(first, (void *) 1));
+    expect_status_success(basicvector_free(first, NULL, NULL));
+    expect_status_success(basicvector_init(&second));
+
+#ifndef BASICVECTOR_NO_HEADER_CACHE
+    assert(first == second, "Expected init to reuse structure freed on the same thread");
+#endif
+    expect_length_to_be(second, 0);
+    expect_status_success(basicvector_free(second, NULL, NULL));
+
+    // Threads overflowing their caches and exiting hand structures over to the global pool
+    for (int i = 0; i < 3; i++) {
+        pthread_create(&threads[i], NULL, header_cache_test__churn, &failures[i]);
+    }
+
+    for (int i = 0; i < 3; i++) {
+        pthread_join(threads[i], NULL);
+        assert(failures[i] == 0, "Expected vectors to work with cached structures");
+    }
+
+    pass("basicvector header cache reuses freed vectors");
+}
+
+void incremental_free_test__count(void *item, void *user_data) {
+    (void) item;
+    (*(int *) user_data)++;
+}
+
+void test_if_basicvector_free_step_deallocates_items_within_budget() {
+    struct basicvector_s *vector;
+    struct basicvector_free_handle_s *handle;
+    int deallocated = 0;
+    size_t remaining;
+
+    expect_status_success(basicvector_init(&vector));
+
+    for (int i = 0; i < 25; i++) {
+        expect_status_success(basicvector_push(vector, &deallocated));
+    }
+
+    expect_status(basicvector_free_begin(NULL, &handle, NULL, NULL), BASICVECTOR_MEMORY_ERROR);
+    expect_status(basicvector_free_begin(vector, NULL, NULL, NULL), BASICVECTOR_INVALID_ARGUMENT);
+    expect_status_success(basicvector_free_begin(vector, &handle, incremental_free_test__count, &deallocated));
+
+    expect_status(basicvector_free_step(handle, 10, NULL), BASICVECTOR_INVALID_ARGUMENT);
+    expect_status_success(basicvector_free_step(handle, 10, &remaining));
+    assert(deallocated == 10 && remaining == 15, "Expected first step to deallocate 10 items");
+    expect_status_success(basicvector_free_step(handle, 10, &remaining));
+    assert(deallocated == 20 && remaining == 5, "Expected second step to deallocate 10 items");
+    expect_status_success(basicvector_free_step(handle, 10, &remaining));
+    assert(deallocated == 25 && remaining == 0, "Expected last step to deallocate remaining items");
+
+    expect_status_success(basicvector_init(&vector));
+    expect_status_success(basicvector_free_begin(vector, &handle, NULL, NULL));
+    expect_status_success(basicvector_free_step(handle, 0, &remaining));
+    assert(remaining == 0, "Expected empty vector to be freed by first step");
+    expect_status(basicvector_free_step(NULL, 1, &remaining), BASICVECTOR_MEMORY_ERROR);
+
+    pass("basicvector_free_step deallocates items within budget");
+}
+
+void test_if_basicvector_free_background_frees_vectors_on_reclaimer_thread() {
+    struct basicvector_s *vector;
+    int deallocated = 0;
+
+    for (int v = 0; v < 3; v++) {
+        expect_status_success(basicvector_init(&vector));
+
+        for (int i = 0; i < 100; i++) {
+            expect_status_success(basicvector_push(vector, &deallocated));
+        }
+
+        expect_status_success(basicvector_free_background(vector, incremental_free_test__count, &deallocated));
+    }
+
+    expect_status_success(basicvector_free_background_wait());
+    assert(deallocated == 300, "Expected reclaimer to deallocate items of every queued vector");
+    expect_status(basicvector_free_background(NULL, NULL, NULL), BASICVECTOR_MEMORY_ERROR);
+
+    pass("basicvector_free_background frees vectors on reclaimer thread");
+}
+
+void test_if_basicvector_splice_and_append_vector_move_items_between_vectors() {
+    struct basicvector_s *destination;
+    struct basicvector_s *source;
+
+    expect_status_success(basicvector_init(&destination));
+    expect_status_success(basicvector_init(&source));
+
+    // Enough items to spill out of inline storage
+    size_t count = BASICVECTOR_SMALL_CAPACITY + 12;
+
+    for (uintptr_t i = 1; i <= count; i++) {
+        expect_status_success(basicvector_push(source, (void *) i));
+    }
+
+    // Empty destination takes over the heap storage of source
+    void **source_storage = source->items;
+    expect_status_success(basicvector_append_vector(destination, source));
+    assert(destination->items == source_storage, "Expected empty destination to take over source storage");
+    expect_length_to_be(destination, count);
+    expect_length_to_be(source, 0);
+
+    for (uintptr_t i = 101; i <= 103; i++) {
+        expect_status_success(basicvector_push(source, (void *) i));
+    }
+
+    expect_status_success(basicvector_splice(destination, 5, source));
+    expect_length_to_be(destination, count + 3);
+    expect_length_to_be(source, 0);
+    expect_item_to_be(destination, 4, (int *) 5);
+    expect_item_to_be(destination, 5, (int *) 101);
+    expect_item_to_be(destination, 7, (int *) 103);
+    expect_item_to_be(destination, 8, (int *) 6);
+    expect_item_to_be(destination, count + 2, (int *) count);
+
+    expect_status_success(basicvector_push(source, (void *) 200));
+    expect_status_success(basicvector_append_vector(destination, source));
+    expect_length_to_be(destination, count + 4);
+    expect_item_to_be(destination, count + 3, (int *) 200);
+
+    expect_status(basicvector_splice(destination, count + 5, source), BASICVECTOR_INVALID_INDEX);
+    expect_status(basicvector_splice(destination, 0, destination), BASICVECTOR_INVALID_ARGUMENT);
+    expect_status(basicvector_append_vector(NULL, source), BASICVECTOR_MEMORY_ERROR);
+    expect_status(basicvector_append_vector(destination, NULL), BASICVECTOR_MEMORY_ERROR);
+
+    expect_status_success(basicvector_free(source, NULL, NULL));
+    expect_status_success(basicvector_free(destination, NULL, NULL));
+
+    pass("basicvector_splice and basicvector_append_vector move items between vectors");
+}
+
+void test_if_basicvector_split_and_truncate_detach_and_drop_tail_items() {
+    struct basicvector_s *vector;
+    struct basicvector_s *tail;
+    int deallocated = 0;
+
+    expect_status_success(basicvector_init(&vector));
+
+    // Enough items for both halves of the split to stay out of inline storage
+    size_t count = BASICVECTOR_SMALL_CAPACITY + 12;
+
+    for (uintptr_t i = 1; i <= count; i++) {
+        expect_status_success(basicvector_push(vector, (void *) i));
+    }
+
+    expect_status_success(basicvector_split(vector, count - 5, &tail));
+    expect_length_to_be(vector, count - 5);
+    expect_length_to_be(tail, 5);
+    expect_item_to_be(vector, count - 6, (int *) (count - 5));
+    expect_item_to_be(tail, 0, (int *) (count - 4));
+    expect_item_to_be(tail, 4, (int *) count);
+    expect_status_success(basicvector_free(tail, NULL, NULL));
+
+    // Splitting at 0 moves the storage to the tail
+    void **storage = vector->items;
+    expect_status_success(basicvector_split(vector, 0, &tail));
+    assert(tail->items == storage, "Expected split at 0 to move storage to the tail");
+    expect_length_to_be(vector, 0);
+    expect_length_to_be(tail, count - 5);
+
+    expect_status(basicvector_split(tail, count - 4, &vector), BASICVECTOR_INVALID_INDEX);
+    expect_status(basicvector_split(tail, 0, NULL), BASICVECTOR_INVALID_ARGUMENT);
+
+    expect_status_success(basicvector_truncate(tail, count - 10, incremental_free_test__count, &deallocated));
+    expect_length_to_be(tail, count - 10);
+    assert(deallocated == 5, "Expected truncate to deallocate dropped items");
+    expect_item_to_be(tail, count - 11, (int *) (count - 10));
+
+    expect_status(basicvector_truncate(tail, count - 9, NULL, NULL), BASICVECTOR_INVALID_INDEX);
+    expect_status(basicvector_truncate(NULL, 0, NULL, NULL), BASICVECTOR_MEMORY_ERROR);
+
+    expect_status_success(basicvector_free(tail, NULL, NULL));
+    expect_status_success(basicvector_free(vector, NULL, NULL));
+
+    pass("basicvector_split and basicvector_truncate detach and drop tail items");
+}
+
+void test_if_basicvector_compact_shrinks_storage_to_fit_items() {
+    struct basicvector_s *vector;
+
+    expect_status_success(basicvector_init(&vector));
+
+    for (uintptr_t i = 1; i <= BASICVECTOR_SMALL_CAPACITY + 1000; i++) {
+        expect_status_success(basicvector_push(vector, (void *) i));
+    }
+
+    size_t heap_length = BASICVECTOR_SMALL_CAPACITY + 100;
+
+    expect_status_success(basicvector_truncate(vector, heap_length, NULL, NULL));
+    expect_status_success(basicvector_compact(vector));
+    assert(vector->capacity == heap_length, "Expected compact to shrink capacity to length");
+    expect_item_to_be(vector, heap_length - 1, (int *) heap_length);
+
+    expect_status_success(basicvector_truncate(vector, BASICVECTOR_SMALL_CAPACITY, NULL, NULL));
+    expect_status_success(basicvector_compact(vector));
+    assert(vector->items == vector->small_items, "Expected compact to move small vector back to inline storage");
+    expect_length_to_be(vector, BASICVECTOR_SMALL_CAPACITY);
+    expect_item_to_be(vector, 0, (int *) 1);
+    expect_item_to_be(vector, BASICVECTOR_SMALL_CAPACITY - 1, (int *) BASICVECTOR_SMALL_CAPACITY);
+
+    expect_status_success(basicvector_compact(vector));
+    expect_status_success(basicvector_push(vector, (void *) (BASICVECTOR_SMALL_CAPACITY + 1)));
+    expect_item_to_be(vector, BASICVECTOR_SMALL_CAPACITY, (int *) (BASICVECTOR_SMALL_CAPACITY + 1));
+    expect_status(basicvector_compact(NULL), BASICVECTOR_MEMORY_ERROR);
+
+    expect_status_success(basicvector_free(vector, NULL, NULL));
+
+    pass("basicvector_compact shrinks storage to fit items");
+}
+
+void test_if_basicvector_large_storage_is_huge_page_aligned_and_accepts_advice() {
+    struct basicvector_s *vector;
+    // Enough items for storage to reach 2 MB, with length within the first half of it
+    size_t length = 2 * 1024 * 1024 / sizeof(void *) + 1;
+
+    expect_status_success(basicvector_init(&vector));
+
+    for (uintptr_t i = 1; i <= length; i++) {
+        expect_status_success(basicvector_push(vector, (void *) i));
+    }
+
+#if defined(__linux__) && !defined(BASICVECTOR_NO_MMAP)
+    assert((uintptr_t) vector->items % (2 * 1024 * 1024) == 0, "Expected large storage to be huge page aligned");
+#endif
+
+    int advices[] = {
+        BASICVECTOR_ADVICE_SEQUENTIAL,
+        BASICVECTOR_ADVICE_RANDOM,
+        BASICVECTOR_ADVICE_WILLNEED,
+        BASICVECTOR_ADVICE_DONTNEED,
+        BASICVECTOR_ADVICE_NORMAL,
+    };
+
+    for (size_t i = 0; i < sizeof(advices) / sizeof(advices[0]); i++) {
+        int status = basicvector_advise(vector, advices[i]);
+        assert(status == BASICVECTOR_SUCCESS || status == BASICVECTOR_UNSUPPORTED, "Expected advice to be accepted or unsupported");
+    }
+
+    // Items survive releasing unused capacity
+    for (size_t i = 0; i < length; i += 4096) {
+        expect_item_to_be(vector, (int) i, (int *) (i + 1));
+    }
+
+    expect_item_to_be(vector, (int) length - 1, (int *) length);
+
+    expect_status(basicvector_advise(vector, 42), BASICVECTOR_INVALID_ARGUMENT);
+    expect_status(basicvector_advise(NULL, BASICVECTOR_ADVICE_NORMAL), BASICVECTOR_MEMORY_ERROR);
+
+    // Shrinking moves storage from the mapping back to the heap
+    expect_status_success(basicvector_truncate(vector, 1000, NULL, NULL));
+    expect_status_success(basicvector_compact(vector));
+    expect_item_to_be(vector, 999, (int *) 1000);
+
+    expect_status_success(basicvector_free(vector, NULL, NULL));
+
+    pass("basicvector large storage is huge page aligned and accepts advice");
+}
+
+void test_if_basicvector_handles_stay_valid_while_items_move() {
+    struct basicvector_s *vector;
+    uint64_t handles[10];
+    void *item;
+    int deallocated = 0;
+
+    expect_status_success(basicvector_init(&vector));
+
+    for (uintptr_t i = 0; i < 10; i++) {
+        expect_status_success(basicvector_insert_handle(vector, (void *) (i + 1), &handles[i]));
+    }
+
+    expect_length_to_be(vector, 10);
+
+    expect_status_success(basicvector_remove_handle(vector, handles[2], incremental_free_test__count, &deallocated));
+    expect_status_success(basicvector_remove_handle(vector, handles[0], incremental_free_test__count, &deallocated));
+    assert(deallocated == 2, "Expected removed items to be deallocated");
+    expect_length_to_be(vector, 8);
+
+    // Removed handles are stale, the rest still reach their items although these have moved
+    expect_status(basicvector_get_handle(vector, handles[2], &item), BASICVECTOR_ITEM_NOT_FOUND);
+    expect_status(basicvector_remove_handle(vector, handles[0], NULL, NULL), BASICVECTOR_ITEM_NOT_FOUND);
+
+    for (int i = 1; i < 10; i++) {
+        if (i == 2) continue;
+
+        expect_status_success(basicvector_get_handle(vector, handles[i], &item));
+        assert(item == (void *) (uintptr_t) (i + 1), "Expected handle to reach its item");
+    }
+
+    // Freed slot is reused with a new generation
+    uint64_t reused;
+    expect_status_success(basicvector_insert_handle(vector, (void *) 100, &reused));
+    assert((uint32_t) reused == (uint32_t) handles[0] && reused != handles[0], "Expected slot to be reused with new generation");
+    expect_status_success(basicvector_get_handle(vector, reused, &item));
+    assert(item == (void *) 100, "Expected reused handle to reach new item");
+    expect_status(basicvector_get_handle(vector, handles[0], &item), BASICVECTOR_ITEM_NOT_FOUND);
+
+    expect_status(basicvector_get_handle(vector, (uint64_t) 1 << 40, &item), BASICVECTOR_ITEM_NOT_FOUND);
+    expect_status(basicvector_get_handle(vector, handles[1], NULL), BASICVECTOR_INVALID_ARGUMENT);
+    expect_status(basicvector_insert_handle(vector, NULL, NULL), BASICVECTOR_INVALID_ARGUMENT);
+
+    expect_status_success(basicvector_free(vector, NULL, NULL));
+
+    pass("basicvector handles stay valid while items move");
+}
+
+int handles_test__compare(void *left, void *right, void *user_data) {
+    (void) user_data;
+    return (uintptr_t) left < (uintptr_t) right ? -1 : (uintptr_t) left > (uintptr_t) right;
+}
+
+void test_if_basicvector_handles_reject_operations_moving_items() {
+    struct basicvector_s *vector;
+    uint64_t handles[3];
+    void *item;
+
+    expect_status_success(basicvector_init(&vector));
+
+    for (uintptr_t i = 0; i < 3; i++) {
+        expect_status_success(basicvector_insert_handle(vector, (void *) (30 - 10 * i), &handles[i]));
+    }
+
+    // Sorting would move items away from the slots their handles point to
+    expect_status(basicvector_sort(vector, handles_test__compare, NULL), BASICVECTOR_UNSUPPORTED);
+    expect_status_success(basicvector_get_handle(vector, handles[0], &item));
+    assert(item == (void *) 30, "Expected handle to keep reaching its item after rejected sort");
+
+    // Removing and pushing behind the handle functions would shift items under the handles
+    expect_status(basicvector_remove(vector, 0, NULL, NULL), BASICVECTOR_UNSUPPORTED);
+    expect_status(basicvector_push(vector, (void *) 4), BASICVECTOR_UNSUPPORTED);
+    expect_status_success(basicvector_get_handle(vector, handles[2], &item));
+    assert(item == (void *) 10, "Expected handle to keep reaching its item after rejected remove and push");
+
+    expect_status(basicvector_remove_batched(vector, 0, 1, NULL, NULL), BASICVECTOR_UNSUPPORTED);
+    expect_status(basicvector_truncate(vector, 1, NULL, NULL), BASICVECTOR_UNSUPPORTED);
+    expect_status(basicvector_set(vector, 5, NULL, NULL, NULL), BASICVECTOR_UNSUPPORTED);
+    expect_status(basicvector_set_batched(vector, 2, (void *[]) { NULL, NULL }, 2, NULL, NULL), BASICVECTOR_UNSUPPORTED);
+    expect_length_to_be(vector, 3);
+
+    expect_status_success(basicvector_remove_handle(vector, handles[2], NULL, NULL));
+    expect_status_success(basicvector_get_handle(vector, handles[1], &item));
+    assert(item == (void *) 20, "Expected remaining handle to reach its item");
+
+    expect_status_success(basicvector_free(vector, NULL, NULL));
+
+    pass("basicvector handles reject operations moving items");
+}
+
+void test_if_basicvector_handles_of_free_slots_are_not_found() {
+    struct basicvector_s *vector;
+    uint64_t handles[2];
+    void *item;
+
+    expect_status_success(basicvector_init(&vector));
+    expect_status_success(basicvector_insert_handle(vector, (void *) 1, &handles[0]));
+    expect_status_success(basicvector_insert_handle(vector, (void *) 2, &handles[1]));
+    expect_status_success(basicvector_remove_handle(vector, handles[0], NULL, NULL));
+
+    // Carries the generation of the freed slot, which holds a free list link instead of an item index
+    uint64_t forged = handles[0] + ((uint64_t) 1 << 32);
+
+    expect_status(basicvector_remove_handle(vector, forged, NULL, NULL), BASICVECTOR_ITEM_NOT_FOUND);
+    expect_status(basicvector_get_handle(vector, forged, &item), BASICVECTOR_ITEM_NOT_FOUND);
+    expect_length_to_be(vector, 1);
+
+    expect_status_success(basicvector_get_handle(vector, handles[1], &item));
+    assert(item == (void *) 2, "Expected remaining handle to reach its item");
+
+    uint64_t reused;
+    expect_status_success(basicvector_insert_handle(vector, (void *) 3, &reused));
+    assert(reused != forged, "Expected reused slot not to match the forged handle");
+    expect_status_success(basicvector_get_handle(vector, reused, &item));
+    assert(item == (void *) 3, "Expected reused slot to reach its new item");
+    expect_length_to_be(vector, 2);
+
+    expect_status_success(basicvector_free(vector, NULL, NULL));
+
+    pass("basicvector handles of free slots are not found");
+}
+
+bool swap_remove_test__is_even(void *item, void *user_data) {
+    (void) user_data;
+    return (uintptr_t) item % 2 == 0;
+}
+
+void swap_remove_test__dealloc(void *item, void *user_data) {
+    (void) item;
+    (*(int *) user_data)++;
+}
+
+void test_if_basicvector_swap_remove_moves_last_item_into_removed_slot() {
+    struct basicvector_s *vector;
+    int deallocated = 0;
+
+    expect_status_success(basicvector_init(&vector));
+
+    for (uintptr_t i = 1; i <= 5; i++) {
+        expect_status_success(basicvector_push(vector, (void *) i));
+    }
+
+    expect_status_success(basicvector_swap_remove(vector, 1, NULL, NULL));
+    expect_length_to_be(vector, 4);
+    expect_item_to_be(vector, 0, (int *) 1);
+    expect_item_to_be(vector, 1, (int *) 5);
+    expect_item_to_be(vector, 3, (int *) 4);
+
+    expect_status_success(basicvector_swap_remove(vector, 3, NULL, NULL));
+    expect_length_to_be(vector, 3);
+    expect_item_to_be(vector, 2, (int *) 3);
+
+    expect_status(basicvector_swap_remove(vector, 3, NULL, NULL), BASICVECTOR_INVALID_INDEX);
+    expect_status(basicvector_swap_remove(NULL, 0, NULL, NULL), BASICVECTOR_MEMORY_ERROR);
+    expect_status_success(basicvector_free(vector, NULL, NULL));
+
+    expect_status_success(basicvector_init(&vector));
+
+    for (uintptr_t i = 1; i <= 100; i++) {
+        expect_status_success(basicvector_push(vector, (void *) (i % 3 == 0 ? i * 2 : i)));
+    }
+
+    expect_status_success(basicvector_swap_remove_if(vector, swap_remove_test__is_even, swap_remove_test__dealloc, &deallocated));
+
+    int length;
+    expect_status_success(basicvector_length(vector, &length));
+    assert(length + deallocated == 100, "Expected every removed item to be deallocated");
+
+    for (int i = 0; i < length; i++) {
+        void *item;
+        expect_status_success(basicvector_get(vector, i, &item));
+        assert(!swap_remove_test__is_even(item, NULL), "Expected no matching items to remain");
+    }
+
+    assert(length == 33, "Expected only odd items not divisible by 3 to remain");
+    expect_status(basicvector_swap_remove_if(vector, NULL, NULL, NULL), BASICVECTOR_INVALID_ARGUMENT);
+
+    expect_status_success(basicvector_free(vector, NULL, NULL));
+
+    pass("basicvector_swap_remove moves last item into removed slot");
+}
+
+void test_if_basicvector_remove_deferred_keeps_logical_indices() {
+    struct basicvector_s *vector;
+    int deallocated = 0;
+    void *item;
+
+    expect_status_success(basicvector_init(&vector));
+    expect_status_success(basicvector_set_tombstone_threshold(vector, 1.0));
+
+    for (uintptr_t i = 1; i <= 300; i++) {
+        expect_status_success(basicvector_push(vector, (void *) i));
+    }
+
+    // Removing while walking the vector, indices after a removed item move down just like with basicvector_remove
+    for (int i = 0; i < 300 - deallocated; ) {
+        expect_status_success(basicvector_get(vector, i, &item));
+
+        if ((uintptr_t) item % 2 == 0) {
+            expect_status_success(basicvector_remove_deferred(vector, (size_t) i, incremental_free_test__count, &deallocated));
+        } else {
+            i++;
+        }
+    }
+
+    assert(deallocated == 150, "Expected every removed item to be deallocated right away");
+    assert(vector->length == 300, "Expected removed slots to stay in place until flushed");
+    expect_length_to_be(vector, 150);
+
+    for (int i = 149; i >= 0; i -= 7) {
+        expect_item_to_be(vector, i, (int *) (uintptr_t) (2 * i + 1));
+    }
+
+    expect_status(basicvector_get(vector, 150, &item), BASICVECTOR_ITEM_NOT_FOUND);
+    expect_status(basicvector_remove_deferred(vector, 150, NULL, NULL), BASICVECTOR_INVALID_INDEX);
+
+    expect_status_success(basicvector_flush(vector));
+    assert(vector->length == 150, "Expected flush to drop removed slots");
+
+    for (int i = 0; i < 150; i++) {
+        expect_item_to_be(vector, i, (int *) (uintptr_t) (2 * i + 1));
+    }
+
+    expect_status_success(basicvector_free(vector, NULL, NULL));
+
+    // Other operations drop pending tombstones before touching the storage
+    expect_status_success(basicvector_init(&vector));
+
+    for (uintptr_t i = 1; i <= 100; i++) {
+        expect_status_success(basicvector_push(vector, (void *) i));
+    }
+
+    expect_status_success(basicvector_remove_deferred(vector, 0, NULL, NULL));
+    expect_status_success(basicvector_push(vector, (void *) 101));
+    assert(vector->length == 100, "Expected push to flush pending tombstones");
+    expect_item_to_be(vector, 0, (int *) 2);
+    expect_item_to_be(vector, 99, (int *) 101);
+
+    // Crossing the default threshold flushes automatically
+    for (int i = 0; i < 25; i++) {
+        expect_status_success(basicvector_remove_deferred(vector, 0, NULL, NULL));
+    }
+
+    assert(vector->length == 100, "Expected tombstones under the threshold to stay");
+    expect_status_success(basicvector_remove_deferred(vector, 0, NULL, NULL));
+    assert(vector->length == 74, "Expected tombstones over the threshold to be dropped");
+    expect_item_to_be(vector, 0, (int *) 28);
+
+    expect_status(basicvector_set_tombstone_threshold(vector, 0.0), BASICVECTOR_INVALID_ARGUMENT);
+    expect_status(basicvector_remove_deferred(NULL, 0, NULL, NULL), BASICVECTOR_MEMORY_ERROR);
+    expect_status(basicvector_flush(NULL), BASICVECTOR_MEMORY_ERROR);
+
+    expect_status_success(basicvector_free(vector, NULL, NULL));
+
+    pass("basicvector_remove_deferred keeps logical indices");
+}
+
+void test_if_basicvector_occupancy_skips_null_items() {
+    struct basicvector_s *vector;
+    size_t count;
+    size_t index;
+
+    expect_status_success(basicvector_init(&vector));
+
+    expect_status(basicvector_next_non_null(vector, 0, &index), BASICVECTOR_ITEM_NOT_FOUND);
+    expect_status_success(basicvector_count_non_null(vector, &count));
+    assert(count == 0, "Expected empty vector to have no non-null items");
+
+    // Long null runs around a few items, the bitmap is then kept up to date by set and push
+    expect_status_success(basicvector_set(vector, 5, (void *) 1, NULL, NULL));
+    expect_status_success(basicvector_count_non_null(vector, &count));
+    expect_status_success(basicvector_set(vector, 300, (void *) 2, NULL, NULL));
+    expect_status_success(basicvector_set(vector, 1000, (void *) 3, NULL, NULL));
+    expect_status_success(basicvector_push(vector, (void *) 4));
+    expect_status_success(basicvector_set(vector, 300, NULL, NULL, NULL));
+    expect_status_success(basicvector_set(vector, 130, (void *) 5, NULL, NULL));
+
+    expect_status_success(basicvector_count_non_null(vector, &count));
+    assert(count == 4, "Expected 4 non-null items");
+
+    size_t expected[] = {5, 130, 1000, 1001};
+    size_t found = 0;
+
+    for (size_t i = 0; basicvector_next_non_null(vector, i, &i) == BASICVECTOR_SUCCESS; i++) {
+        assert(found < 4 && i == expected[found], "Expected iteration to visit non-null items in order");
+        found++;
+    }
+
+    assert(found == 4, "Expected iteration to visit every non-null item");
+
+    // Removal shifts items and invalidates the bitmap, which is rebuilt on next use
+    expect_status_success(basicvector_remove(vector, 0, NULL, NULL));
+    expect_status_success(basicvector_next_non_null(vector, 0, &index));
+    assert(index == 4, "Expected rebuilt bitmap to follow shifted items");
+
+    expect_status_success(basicvector_swap_remove(vector, 4, NULL, NULL));
+    expect_status_success(basicvector_count_non_null(vector, &count));
+    assert(count == 3, "Expected swap remove to update count");
+    expect_status_success(basicvector_next_non_null(vector, 0, &index));
+    assert(index == 4, "Expected last item to be moved into removed slot");
+
+    expect_status(basicvector_next_non_null(vector, 1001, &index), BASICVECTOR_ITEM_NOT_FOUND);
+    expect_status(basicvector_next_non_null(vector, 0, NULL), BASICVECTOR_INVALID_ARGUMENT);
+    expect_status(basicvector_count_non_null(NULL, &count), BASICVECTOR_MEMORY_ERROR);
+
+    expect_status_success(basicvector_free(vector, NULL, NULL));
+
+    pass("basicvector occupancy bitmap skips null items");
+}
+
+int heap_test__compare(void *left, void *right, void *user_data) {
+    (void) user_data;
+    return (uintptr_t) left < (uintptr_t) right ? -1 : (uintptr_t) left > (uintptr_t) right;
+}
+
+void test_if_basicvector_heap_pops_items_in_order() {
+    int arities[] = {BASICVECTOR_HEAP_BINARY, 3, BASICVECTOR_HEAP_QUATERNARY};
+
+    for (size_t a = 0; a < sizeof(arities) / sizeof(arities[0]); a++) {
+        struct basicvector_s *vector;
+        void *item;
+
+        expect_status_success(basicvector_init(&vector));
+        expect_status(basicvector_heap_peek(vector, &item), BASICVECTOR_ITEM_NOT_FOUND);
+        expect_status(basicvector_heap_pop(vector, &item, arities[a], heap_test__compare, NULL), BASICVECTOR_ITEM_NOT_FOUND);
+
+        // Half of the items is heapified at once, the other half pushed one by one
+        for (uintptr_t i = 0; i < 500; i++) {
+            expect_status_success(basicvector_push(vector, (void *) ((i * 7919) % 1000 + 1)));
+        }
+
+        expect_status_success(basicvector_heapify(vector, arities[a], heap_test__compare, NULL));
+
+        for (uintptr_t i = 500; i < 1000; i++) {
+            expect_status_success(basicvector_heap_push(vector, (void *) ((i * 7919) % 1000 + 1), arities[a], heap_test__compare, NULL));
+        }
+
+        expect_status_success(basicvector_heap_peek(vector, &item));
+        assert(item == (void *) 1, "Expected peek to return the lowest item");
+
+        for (uintptr_t i = 1; i <= 1000; i++) {
+            expect_status_success(basicvector_heap_pop(vector, &item, arities[a], heap_test__compare, NULL));
+            assert(item == (void *) i, "Expected heap to pop items in order");
+        }
+
+        expect_length_to_be(vector, 0);
+
+        expect_status(basicvector_heap_push(vector, NULL, 1, heap_test__compare, NULL), BASICVECTOR_INVALID_ARGUMENT);
+        expect_status(basicvector_heapify(vector, 2, NULL, NULL), BASICVECTOR_INVALID_ARGUMENT);
+        expect_status(basicvector_heap_pop(vector, NULL, 2, heap_test__compare, NULL), BASICVECTOR_INVALID_ARGUMENT);
+        expect_status(basicvector_heap_peek(NULL, &item), BASICVECTOR_MEMORY_ERROR);
+
+        expect_status_success(basicvector_free(vector, NULL, NULL));
+    }
+
+    pass("basicvector heap pops items in order");
+}
+
+uint64_t filter_test__hash(void *item, void *user_data) {
+    (void) user_data;
+    return (uint64_t) (uintptr_t) item * 0x9E3779B97F4A7C15ULL;
+}
+
+struct filter_test__search_s {
+    void *wanted;
+    int calls;
+};
+
+bool filter_test__search(void *item, void *user_data) {
+    struct filter_test__search_s *search = user_data;
+
+    search->calls++;
+    return item == search->wanted;
+}
+
+void test_if_basicvector_find_by_hash_skips_scan_for_absent_items() {
+    struct basicvector_s *vector;
+    struct filter_test__search_s search = {0};
+    void *result;
+
+    expect_status_success(basicvector_init(&vector));
+
+    for (uintptr_t i = 1; i <= 1000; i++) {
+        expect_status_success(basicvector_push(vector, (void *) i));
+    }
+
+    // Without filter it behaves like basicvector_find
+    search.wanted = (void *) 5000;
+    expect_status(basicvector_find_by_hash(vector, &result, filter_test__hash((void *) 5000, NULL), filter_test__search, &search), BASICVECTOR_ITEM_NOT_FOUND);
+    assert(search.calls == 1000, "Expected full scan without filter");
+
+    expect_status(basicvector_filter_enable(vector, NULL, NULL), BASICVECTOR_INVALID_ARGUMENT);
+    expect_status_success(basicvector_filter_enable(vector, filter_test__hash, NULL));
+
+    // Items pushed and set after enabling are found, absent ones mostly skip the scan
+    expect_status_success(basicvector_push(vector, (void *) 1001));
+    expect_status_success(basicvector_set(vector, 0, (void *) 2000, NULL, NULL));
+
+    uintptr_t present[] = {2, 500, 1000, 1001, 2000};
+
+    for (size_t i = 0; i < sizeof(present) / sizeof(present[0]); i++) {
+        search.wanted = (void *) present[i];
+        expect_status_success(basicvector_find_by_hash(vector, &result, filter_test__hash(search.wanted, NULL), filter_test__search, &search));
+        assert(result == search.wanted, "Expected present item to be found");
+    }
+
+    int scans = 0;
+
+    for (uintptr_t i = 3000; i < 4000; i++) {
+        search.wanted = (void *) i;
+        search.calls = 0;
+        expect_status(basicvector_find_by_hash(vector, &result, filter_test__hash(search.wanted, NULL), filter_test__search, &search), BASICVECTOR_ITEM_NOT_FOUND);
+        assert(result == NULL, "Expected null result for absent item");
+        if (search.calls > 0) scans++;
+    }
+
+    assert(scans < 50, "Expected filter to rule out most absent items");
+
+    // Items moved in at once are taken into account after a rebuild
+    struct basicvector_s *source;
+    expect_status_success(basicvector_init(&source));
+    expect_status_success(basicvector_push(source, (void *) 7777));
+    expect_status_success(basicvector_append_vector(vector, source));
+
+    search.wanted = (void *) 7777;
+    expect_status_success(basicvector_find_by_hash(vector, &result, filter_test__hash(search.wanted, NULL), filter_test__search, &search));
+
+    expect_status_success(basicvector_filter_disable(vector));
+    expect_status(basicvector_filter_disable(NULL), BASICVECTOR_MEMORY_ERROR);
+    expect_status(basicvector_find_by_hash(vector, NULL, 0, filter_test__search, &search), BASICVECTOR_INVALID_ARGUMENT);
+
+    expect_status_success(basicvector_filter_enable(vector, filter_test__hash, NULL));
+    expect_status_success(basicvector_free(source, NULL, NULL));
+    expect_status_success(basicvector_free(vector, NULL, NULL));
+
+    pass("basicvector_find_by_hash skips scan for absent items");
+}
+
+uint64_t filter_test__hash_value(void *item, void *user_data) {
+    (void) user_data;
+    return (uint64_t) *(int *) item * 0x9E3779B97F4A7C15ULL;
+}
+
+bool filter_test__search_value(void *item, void *user_data) {
+    return item != NULL && *(int *) item == *(int *) user_data;
+}
+
+void test_if_basicvector_filter_skips_null_gap_items() {
+    struct basicvector_s *vector;
+    int a = 42, b = 43, missing = 44;
+    void *result;
+
+    expect_status_success(basicvector_init(&vector));
+
+    // Indexes 0 to 2 are null gaps, a hash function dereferencing them would crash
+    expect_status_success(basicvector_set(vector, 3, &a, NULL, NULL));
+    expect_status_success(basicvector_filter_enable(vector, filter_test__hash_value, NULL));
+    expect_status_success(basicvector_set(vector, 6, &b, NULL, NULL));
+    expect_length_to_be(vector, 7);
+
+    expect_status_success(basicvector_find_by_hash(vector, &result, filter_test__hash_value(&a, NULL), filter_test__search_value, &a));
+    assert(result == &a, "Expected item set before enabling the filter to be found");
+    expect_status_success(basicvector_find_by_hash(vector, &result, filter_test__hash_value(&b, NULL), filter_test__search_value, &b));
+    assert(result == &b, "Expected item set after enabling the filter to be found");
+    expect_status(basicvector_find_by_hash(vector, &result, filter_test__hash_value(&missing, NULL), filter_test__search_value, &missing), BASICVECTOR_ITEM_NOT_FOUND);
+
+    expect_status_success(basicvector_free(vector, NULL, NULL));
+
+    pass("basicvector filter skips null gap items");
+}
+
+int main() {
+    test_if_basicvector_init_returns_valid_struct_pointer();
+    test_if_basicvector_init_inplace_stores_small_vectors_without_allocations_and_spills_to_heap();
+
+    // basicvector length
+    test_if_basicvector_length_returns_valid_length();
+    test_if_basicvector_length_returns_memory_error_when_passed_null_as_vector();
+    test_if_basicvector_length_returns_invalid_argument_when_passed_null_as_result();
+
+    // basicvector_push
+    test_if_basicvector_push_pushes_item_at_the_end_of_the_vector();
+    test_if_basicvector_push_returns_memory_error_when_passed_null_as_a_vector();
+
+    // basicvector_set
+    test_if_basicvector_set_skips_execution_of_deallocation_function_when_it_is_null_and_there_is_one_item_inside_the_vector();
+    test_if_basicvector_set_skips_execution_of_deallocation_function_when_it_is_null_and_there_are_two_items_inside_the_vector();
+    test_if_basicvector_set_executes_deallocation_function_and_provides_valid_item_and_user_data_to_it_when_there_is_one_item_inside_the_vector();
+    test_if_basicvector_set_executes_deallocation_function_and_provides_valid_item_and_user_data_to_it_when_there_are_two_items_inside_the_vector();
+    test_if_basicvector_set_sets_item_in_the_middle_of_the_vector();
+    test_if_basicvector_set_fills_non_existent_items_with_null_items();
+    test_if_basicvector_set_sets_first_item_when_no_items_are_inside_the_vector();
+    test_if_basicvector_set_sets_first_item_when_there_are_more_than_one_inside_the_vector();
+    test_if_basicvector_set_returns_invalid_index_error_when_index_is_less_than_zero();
+    test_if_basicvector_set_returns_memory_error_when_vector_is_null();
+
+    // basicvector_set
+    test_if_basicvector_get_returns_memory_error_when_vector_is_null();
+    test_if_basicvector_get_returns_invalid_index_error_when_no_items_are_inside();
+    test_if_basicvector_get_returns_item_not_found_error_when_provided_index_equal_to_length();
+    test_if_basicvector_get_returns_proper_value_when_provided_last_item_index_and_there_is_only_one_item_inside_vector();
+    test_if_basicvector_get_returns_proper_value_when_provided_last_item_index();
+
+    // find
+    test_if_basicvector_find_returns_memory_error_when_vector_is_null();
+    test_if_basicvector_find_returns_invalid_argument_error_when_result_argument_is_null();
+    test_if_basicvector_find_returns_invalid_argument_error_when_search_function_is_null();
+    test_if_basicvector_find_passes_valid_user_data_pointer_to_search_function();
+    test_if_basicvector_find_returns_item_not_found_and_assigns_null_to_result_when_vector_is_empty();
+    test_if_basicvector_find_returns_item_not_found_and_assigns_null_to_result_when_vector_has_items_and_search_function_does_not_match_any_items();
+    test_if_basicvector_find_returns_success_and_assigns_item_to_result_when_vector_has_at_least_two_items_and_search_function_matches_item();
+    test_if_basicvector_find_returns_success_and_assigns_item_to_result_when_vector_has_one_item_and_search_function_matches_item();
+
+    test_if_basicvector_remove_returns_memory_error_when_vector_is_null();
+    test_if_basicvector_remove_returns_invalid_index_error_when_provided_index_is_below_zero();
+    test_if_basicvector_remove_skips_execution_of_deallocation_function_when_provided_deallocation_function_is_null_and_vector_has_one_item();
+    test_if_basicvector_remove_skips_execution_of_deallocation_function_when_provided_deallocation_function_is_null_and_vector_has_two_items();
+    test_if_basicvector_remove_executes_deallocation_function_on_every_item_with_valid_user_data_and_item_when_used_on_first_item_of_vector();
+    test_if_basicvector_remove_executes_deallocation_function_on_every_item_with_valid_user_data_and_item_when_used_on_second_item_of_vector();
+    test_if_basicvector_remove_returns_invalid_index_error_when_vector_does_not_have_any_items();
+    test_if_basicvector_remove_returns_invalid_index_error_when_vector_has_one_item_and_provided_index_is_1();
+    test_if_basicvector_remove_returns_invalid_index_error_when_vector_has_two_items_and_provided_index_is_2();
+    test_if_basicvector_remove_removes_first_item();
+    test_if_basicvector_remove_removes_second_item();
+    test_if_basicvector_remove_removes_third_item();
+    test_if_basicvector_swap_remove_moves_last_item_into_removed_slot();
+    test_if_basicvector_remove_deferred_keeps_logical_indices();
+
+    test_if_basicvector_free_returns_memory_error_when_passed_vector_is_null();
+    test_if_basicvector_free_returns_success_when_deallocation_func_is_null();
+    test_if_basicvector_free_executes_deallocation_function_with_valid_user_data_on_every_item();
+    test_if_basicvector_free_step_deallocates_items_within_budget();
+    test_if_basicvector_free_background_frees_vectors_on_reclaimer_thread();
+
+    // basicvector_find_index
+    basicvector_find_index_test_1__test_if_returns_memory_error_when_provided_vector_is_null();
+    basicvector_find_index_test_2__test_if_returns_invalid_argument_when_provided_search_function_is_null();
+    basicvector_find_index_test_3__test_if_returns_invalid_argument_when_provided_result_ptr_is_null();
+    basicvector_find_index_test_4__test_if_returns_item_not_found_error_when_no_items_are_inside();
+    basicvector_find_index_test_5__test_if_returns_item_not_found_error_when_search_function_returns_false_on_every_item();
+    basicvector_find_index_test_6__test_if_returns_success_and_assigns_index_to_result_when_search_function_returns_true_on_some_item();
+    basicvector_find_index_test_7__test_if_goes_through_every_item_and_passes_correct_arguments();
+
+    // basicvector_stats
+    test_if_basicvector_stats_returns_memory_error_when_vector_is_null();
+    test_if_basicvector_stats_returns_invalid_argument_when_result_is_null();
+    test_if_basicvector_stats_counts_calls_allocations_and_walked_entries();
+    test_if_basicvector_memory_usage_reports_storage_and_slack();
+
+    // inline accessors
+    test_if_basicvector_unchecked_accessors_match_checked_ones();
+
+    // 64-bit api
+    test_if_basicvector_64bit_api_matches_int_api();
+    test_if_basicvector_array_conversions_keep_items_in_order();
+
+    // parallel operations
+    test_if_basicvector_parallel_for_each_visits_every_item_once();
+    test_if_basicvector_map_into_and_reduce_parallel_compute_valid_results();
+    test_if_basicvector_pool_runs_parallel_operations_on_custom_pool();
+    test_if_basicvector_parallel_operations_can_be_nested();
+    test_if_basicvector_free_parallel_deallocates_every_item();
+    test_if_basicvector_sharded_collects_items_of_all_threads();
+    test_if_basicvector_header_cache_reuses_freed_vectors();
+
+    // batched deallocation
+    test_if_basicvector_batched_operations_pass_items_in_single_batches();
+
+    // splice, append, split and truncate
+    test_if_basicvector_splice_and_append_vector_move_items_between_vectors();
+    test_if_basicvector_split_and_truncate_detach_and_drop_tail_items();
+    test_if_basicvector_compact_shrinks_storage_to_fit_items();
+
+    // bloom filter
+    test_if_basicvector_find_by_hash_skips_scan_for_absent_items();
+    test_if_basicvector_filter_skips_null_gap_items();
+
+    // heap
+    test_if_basicvector_heap_pops_items_in_order();
+
+    // occupancy bitmap
+    test_if_basicvector_occupancy_skips_null_items();
+
+    // generational handles
+    test_if_basicvector_handles_stay_valid_while_items_move();
+    test_if_basicvector_handles_reject_operations_moving_items();
+    test_if_basicvector_handles_of_free_slots_are_not_found();
+
+    // huge pages and advice
+    test_if_basicvector_large_storage_is_huge_page_aligned_and_accepts_advice();
+
+    // BASICVECTOR_DEFINE
+    test_if_typed_vector_stores_items_by_value();
 
     pass("All passed");
 